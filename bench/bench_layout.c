@@ -0,0 +1,190 @@
+/*
+ * BSD 2-Clause License
+ * Copyright (c) 2024, Yazeed Alharthi
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *	1. Redistributions of source code must retain the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer.
+ *
+ *	2. Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Times the layouts in layout.c on synthetic trees of 10 to 10,000
+ * leaves and reports the cost per leaf. Run with `make bench-layout`.
+ *
+ * Only layout.c is linked: the trees are built here, the parameters
+ * are the compiled in defaults and no X connection is needed. Leaves
+ * are split breadth first over an area large enough that even the
+ * 10,000 leaf tree keeps every window a sane size, and the default
+ * layout is checked to keep all leaves inside it.
+ *
+ * The master, stack and grid layouts walk the leaf sequence, which is
+ * threaded here in order the way tree.c keeps it, and should cost the
+ * same per leaf at every size.
+ *
+ * The last column is the cost of a whole incremental pass after one
+ * split is marked dirty, which should grow with the depth of the tree
+ * rather than with the number of leaves.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_util.h"
+#include "layout.h"
+#include "type.h"
+
+#define MAX_LEAVES 10000
+
+static client_t clients[MAX_LEAVES];
+
+static const layout_params_t params = {
+	.window_gap	  = W_GAP,
+	.border_width = BORDER_WIDTH,
+	.master_ratio = MASTER_RATIO,
+};
+
+static const rectangle_t area = {0, 0, 32000, 18000};
+
+static int
+inside(const node_t *n, const rectangle_t *a)
+{
+	if (n->first_child != NULL || n->second_child != NULL)
+		return inside(n->first_child, a) && inside(n->second_child, a);
+
+	const rectangle_t r = n->rectangle;
+	return r.width > 0 && r.height > 0 && r.x >= a->x && r.y >= a->y &&
+		   r.x + r.width <= a->x + a->width &&
+		   r.y + r.height <= a->y + a->height;
+}
+
+/* what mark_dirty() in tree.c does, without a desktop */
+static void
+mark(node_t *n)
+{
+	n->is_dirty = true;
+	for (node_t *p = n->parent; p != NULL; p = p->parent) {
+		p->is_dirty_below = true;
+	}
+}
+
+static void
+count_leaf(node_t *leaf, void *arg)
+{
+	(void)leaf;
+	(*(long *)arg)++;
+}
+
+static void
+run(int leaves)
+{
+	node_t		*root	= bench_build_tree(leaves, true, clients);
+	node_t		*last	= NULL;
+	node_t		*master = bench_thread_leaves(root, &last);
+	const int	 iters	= 2000000 / leaves;
+	const double scale	= 1.0 / ((double)iters * leaves);
+	node_t		*split	= master->parent;
+	long		 seen	= 0;
+	double		 t0, def, mst, stk, grd, dty;
+
+	t0 = bench_now_ns();
+	for (int i = 0; i < iters; i++) {
+		layout_default(root, area, &params);
+	}
+	def = (bench_now_ns() - t0) * scale;
+
+	if (!inside(root, &area)) {
+		fprintf(stderr, "leaf outside the area at %d leaves\n", leaves);
+		exit(EXIT_FAILURE);
+	}
+
+	t0 = bench_now_ns();
+	for (int i = 0; i < iters; i++) {
+		mark(split);
+		layout_dirty(root, &params, count_leaf, &seen);
+	}
+	dty = (bench_now_ns() - t0) / iters;
+
+	if (seen < iters || !inside(root, &area)) {
+		fprintf(stderr, "incremental pass wrong at %d leaves\n", leaves);
+		exit(EXIT_FAILURE);
+	}
+
+	t0 = bench_now_ns();
+	for (int i = 0; i < iters; i++) {
+		layout_flat(MASTER, master, master, area, &params, NULL, NULL);
+	}
+	mst = (bench_now_ns() - t0) * scale;
+
+	t0 = bench_now_ns();
+	for (int i = 0; i < iters; i++) {
+		layout_flat(STACK, master, NULL, area, &params, NULL, NULL);
+	}
+	stk = (bench_now_ns() - t0) * scale;
+
+	t0 = bench_now_ns();
+	for (int i = 0; i < iters; i++) {
+		layout_flat(GRID, master, NULL, area, &params, NULL, NULL);
+	}
+	grd = (bench_now_ns() - t0) * scale;
+
+	if (!inside(root, &area)) {
+		fprintf(stderr, "grid leaf outside the area at %d\n", leaves);
+		exit(EXIT_FAILURE);
+	}
+
+	printf("%6d %12.1f %12.1f %12.1f %12.1f %12.1f\n",
+		   leaves,
+		   def,
+		   mst,
+		   stk,
+		   grd,
+		   dty);
+	bench_free_nodes(root);
+}
+
+int
+main(void)
+{
+	const int sizes[] = {10, 100, 1000, MAX_LEAVES};
+
+	printf("%6s %12s %12s %12s %12s %12s\n",
+		   "leaves",
+		   "default ns",
+		   "master ns",
+		   "stack ns",
+		   "grid ns",
+		   "split ns");
+	printf("%6s %12s %12s %12s %12s %12s\n",
+		   "",
+		   "per leaf",
+		   "per leaf",
+		   "per leaf",
+		   "per leaf",
+		   "per pass");
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+		run(sizes[i]);
+	}
+	return 0;
+}
@@ -0,0 +1,189 @@
+/*
+ * BSD 2-Clause License
+ * Copyright (c) 2024, Yazeed Alharthi
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *	1. Redistributions of source code must retain the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer.
+ *
+ *	2. Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Compares the directional neighbour search cycle_win used to do, a
+ * breadth first walk over the whole tree, with the per-desktop sorted
+ * edge lists in spatial.c on a desktop of 500 leaves. Run with
+ * `make bench-spatial`.
+ *
+ * Every leaf is asked for its neighbour in all four directions. The
+ * rebuild after a layout change is timed on its own, since it is paid
+ * once per change rather than once per keypress.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_util.h"
+#include "helper.h"
+#include "layout.h"
+#include "spatial.h"
+#include "type.h"
+
+#define LEAVES 500
+
+static client_t clients[LEAVES];
+
+static const layout_params_t params = {
+	.window_gap	  = W_GAP,
+	.border_width = BORDER_WIDTH,
+	.master_ratio = MASTER_RATIO,
+};
+
+static const rectangle_t area = {0, 0, 3840, 2160};
+
+static int32_t
+distance(const rectangle_t *a, const rectangle_t *b, direction_t d)
+{
+	switch (d) {
+	case LEFT: return a->x - (b->x + b->width);
+	case RIGHT: return b->x - (a->x + a->width);
+	case UP: return a->y - (b->y + b->height);
+	case DOWN: return b->y - (a->y + a->height);
+	default: return INT16_MAX;
+	}
+}
+
+static bool
+within_range(const rectangle_t *a, const rectangle_t *b, direction_t d)
+{
+	switch (d) {
+	case LEFT:
+	case RIGHT:
+		return distance(a, b, d) >= 0 && a->y < b->y + b->height &&
+			   a->y + a->height > b->y;
+	case UP:
+	case DOWN:
+		return distance(a, b, d) >= 0 && a->x < b->x + b->width &&
+			   a->x + a->width > b->x;
+	default: return false;
+	}
+}
+
+/* the breadth first walk find_closest_neighbor() did, with a queue big
+ * enough for the tree instead of its old fixed 50 slots */
+static node_t *
+bfs_nearest(node_t *root, node_t *node, direction_t d, node_t **queue)
+{
+	node_t *closest			 = NULL;
+	int32_t closest_distance = INT16_MAX;
+	int		front = 0, rear = 0;
+
+	queue[rear++] = root;
+	while (front < rear) {
+		node_t *current = queue[front++];
+		if (current != node && IS_EXTERNAL(current) &&
+			within_range(&node->rectangle, &current->rectangle, d)) {
+			const int32_t dist =
+				distance(&node->rectangle, &current->rectangle, d);
+			if (dist < closest_distance) {
+				closest_distance = dist;
+				closest			 = current;
+			}
+		}
+		if (current->first_child != NULL)
+			queue[rear++] = current->first_child;
+		if (current->second_child != NULL)
+			queue[rear++] = current->second_child;
+	}
+	return closest;
+}
+
+int
+main(void)
+{
+	const int	iters = 20;
+	node_t	   *root  = bench_build_tree(LEAVES, true, clients);
+	node_t	  **queue = malloc(sizeof(node_t *) * LEAVES * 2);
+	desktop_t	d	  = {0};
+	double		t0, bfs, idx, build;
+	long		sink = 0;
+
+	/* breadth first splits under the default layout leave every leaf
+	 * with a neighbour on most sides */
+	layout_default(root, area, &params);
+	d.first_leaf = bench_thread_leaves(root, &d.last_leaf);
+
+	t0 = bench_now_ns();
+	for (int i = 0; i < iters; i++) {
+		d.spatial.is_valid = false;
+		spatial_build(&d.spatial, &d);
+	}
+	build = (bench_now_ns() - t0) / iters;
+
+	t0 = bench_now_ns();
+	for (int i = 0; i < iters; i++) {
+		for (node_t *n = d.first_leaf; n != NULL; n = n->next_leaf) {
+			for (direction_t dir = LEFT; dir <= DOWN; dir++) {
+				sink += bfs_nearest(root, n, dir, queue) != NULL;
+			}
+		}
+	}
+	bfs = (bench_now_ns() - t0) / ((double)iters * LEAVES * 4);
+
+	t0 = bench_now_ns();
+	for (int i = 0; i < iters; i++) {
+		for (node_t *n = d.first_leaf; n != NULL; n = n->next_leaf) {
+			for (direction_t dir = LEFT; dir <= DOWN; dir++) {
+				sink += spatial_nearest(&d, n, dir) != NULL;
+			}
+		}
+	}
+	idx = (bench_now_ns() - t0) / ((double)iters * LEAVES * 4);
+
+	/* ties between equally distant leaves may resolve differently, so
+	 * the two searches are compared by distance */
+	for (node_t *n = d.first_leaf; n != NULL; n = n->next_leaf) {
+		for (direction_t dir = LEFT; dir <= DOWN; dir++) {
+			node_t *a = bfs_nearest(root, n, dir, queue);
+			node_t *b = spatial_nearest(&d, n, dir);
+			if ((a == NULL) != (b == NULL) ||
+				(a != NULL && distance(&n->rectangle, &a->rectangle,
+									   dir) != distance(&n->rectangle,
+														&b->rectangle,
+														dir))) {
+				fprintf(stderr, "searches disagree\n");
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	printf("%d leaves, %ld neighbours found\n", LEAVES, sink);
+	printf("%-24s %10.0f ns\n", "tree walk per search", bfs);
+	printf("%-24s %10.0f ns\n", "edge lists per search", idx);
+	printf("%-24s %10.0f ns\n", "edge lists rebuild", build);
+
+	spatial_free(&d.spatial);
+	free(queue);
+	bench_free_nodes(root);
+	return 0;
+}
@@ -0,0 +1,472 @@
+/*
+ * BSD 2-Clause License
+ * Copyright (c) 2024, Yazeed Alharthi
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *	1. Redistributions of source code must retain the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer.
+ *
+ *	2. Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Stress run over the tree, registry and pools with far more windows
+ * and desktops than the old 8-bit counters allowed: 2000 windows are
+ * opened on one desktop, spread over 500 desktops and every desktop is
+ * switched to a few times before all windows are closed again. Run
+ * with `make bench-stress`.
+ *
+ * tree.c is linked as is; the X side of zwm.c it calls into is replaced
+ * with stand-ins below that only keep the state tree.c reads back. Each
+ * phase is timed in batches so growth beyond linear shows up as a
+ * rising cost per operation, and the counters are checked after every
+ * phase. The first spread batch also allocates the first pool slabs of
+ * all 500 desktops, so it is expected to stand out.
+ *
+ * A last phase switches back and forth between two desktops of 25
+ * windows and counts the requests the stand-ins would have zwm.c send
+ * for the windows shown and hidden. It runs twice: once checked, with
+ * the stand-ins sending and waiting on every request the way zwm.c used
+ * to, and once the way zwm.c does now. This counts requests, it does
+ * not time them; there is no X server to answer them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pool.h"
+#include "registry.h"
+#include "tree.h"
+#include "type.h"
+#include "zwm.h"
+
+#define WINDOWS	 2000
+#define DESKTOPS 500
+#define ROUNDS	 4
+#define BATCHES	 4
+#define SWITCHED 25
+
+config_t	 conf;
+wm_t		*wm;
+monitor_t	*cur_monitor;
+monitor_t	*prim_monitor;
+monitor_t	*head_monitor;
+
+static wm_t			w;
+static monitor_t	mon;
+static xcb_window_t under_cursor = XCB_NONE;
+/* requests zwm.c would send for what the stand-ins below were asked,
+ * and how many of them it would wait on */
+static uint32_t		sent;
+static uint32_t		waited;
+/* send everything and wait on it, whatever the client's state */
+static bool			checked;
+
+xcb_window_t
+get_window_under_cursor(xcb_conn_t *conn, xcb_window_t win)
+{
+	(void)conn;
+	(void)win;
+	return under_cursor;
+}
+
+uint32_t
+get_focused_desktop_idx(void)
+{
+	return mon.focused_desktop_idx;
+}
+
+monitor_t *
+get_monitor_from_desktop(desktop_t *desktop)
+{
+	(void)desktop;
+	return &mon;
+}
+
+layout_params_t
+get_layout_params(void)
+{
+	return (layout_params_t){W_GAP, BORDER_WIDTH, MASTER_RATIO};
+}
+
+rectangle_t
+get_work_area(const monitor_t *m)
+{
+	return m->rectangle;
+}
+
+static void
+send_request(void)
+{
+	sent++;
+	if (checked)
+		waited++;
+}
+
+/* checked, the WM_STATE atom was looked up again on every write */
+static void
+set_wm_state(client_t *c, uint32_t state)
+{
+	if (checked)
+		send_request();
+	if (checked || c->wm_state != state) {
+		c->wm_state = state;
+		send_request();
+	}
+}
+
+int
+hide_window(client_t *c)
+{
+	if (checked || c->is_mapped)
+		send_request();
+	c->is_mapped = false;
+	set_wm_state(c, XCB_ICCCM_WM_STATE_ICONIC);
+	return 0;
+}
+
+int
+show_window(client_t *c)
+{
+	if (checked || !c->is_mapped)
+		send_request();
+	c->is_mapped = true;
+	set_wm_state(c, XCB_ICCCM_WM_STATE_NORMAL);
+	return 0;
+}
+
+/* border colour and width when they change, input focus and a restack */
+int
+set_focus(node_t *n, bool flag)
+{
+	client_t	  *c	 = n->client;
+	const uint32_t color = flag ? conf.active_border_color
+								: conf.normal_border_color;
+	if (checked || c->border_color != color) {
+		c->border_color = color;
+		send_request();
+	}
+	if (checked || c->border_width != conf.border_width) {
+		c->border_width = conf.border_width;
+		send_request();
+	}
+	send_request();
+	if (flag)
+		send_request();
+	n->is_focused = flag;
+	return 0;
+}
+
+void
+schedule_render(desktop_t *d)
+{
+	d->is_dirty			= true;
+	d->spatial.is_valid = false;
+}
+
+int
+tile(node_t *node)
+{
+	(void)node;
+	return 0;
+}
+
+void
+raise_window(xcb_window_t win)
+{
+	(void)win;
+}
+
+void
+lower_window(xcb_window_t win)
+{
+	(void)win;
+}
+
+void
+window_grab_buttons(xcb_window_t win)
+{
+	(void)win;
+	sent += 3;
+}
+
+void
+window_above(xcb_window_t a, xcb_window_t b)
+{
+	(void)a;
+	(void)b;
+}
+
+void
+window_below(xcb_window_t a, xcb_window_t b)
+{
+	(void)a;
+	(void)b;
+}
+
+static void
+fail(const char *what)
+{
+	fprintf(stderr, "stress: %s\n", what);
+	exit(EXIT_FAILURE);
+}
+
+static double
+now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void
+init_monitor(void)
+{
+	conf = (config_t){.border_width			= BORDER_WIDTH,
+					  .window_gap			= W_GAP,
+					  .virtual_desktops		= DESKTOPS,
+					  .focus_follow_pointer = true};
+	wm	 = &w;
+	mon	 = (monitor_t){.rectangle = {0, 0, 3840, 2160},
+					   .n_of_desktops = DESKTOPS};
+	mon.desktops = calloc(DESKTOPS, sizeof(desktop_t *));
+	if (mon.desktops == NULL)
+		fail("calloc");
+	for (uint32_t i = 0; i < DESKTOPS; i++) {
+		desktop_t *d = calloc(1, sizeof(desktop_t));
+		if (d == NULL)
+			fail("calloc");
+		pool_init(&d->node_pool, sizeof(node_t));
+		pool_init(&d->client_pool, sizeof(client_t));
+		d->monitor	  = &mon;
+		d->id		  = i;
+		d->layout	  = DEFAULT;
+		d->is_focused = (i == 0);
+		snprintf(d->name, sizeof(d->name), "%u", i + 1);
+		mon.desktops[i] = d;
+	}
+	mon.focused_desktop = mon.desktops[0];
+	cur_monitor = prim_monitor = head_monitor = &mon;
+}
+
+/* what insert_into_desktop() does once the window is known to zwm */
+static void
+open_window(desktop_t *d, xcb_window_t win, xcb_window_t at)
+{
+	client_t *c = pool_alloc(&d->client_pool);
+	if (c == NULL)
+		fail("pool_alloc");
+	memset(c, 0, sizeof(*c));
+	c->window	 = win;
+	c->state	 = TILED;
+	c->is_mapped = true;
+
+	if (d->tree == NULL) {
+		d->tree			   = init_root(d);
+		d->tree->client	   = c;
+		d->tree->rectangle = mon.rectangle;
+		relink_leaves(d);
+		registry_attach(win, &mon, d, d->tree);
+	} else {
+		node_t *n = create_node(c, d);
+		node_t *p = find_node_by_window_id(d->tree, at);
+		if (n == NULL || p == NULL)
+			fail("no node to split");
+		insert_node(p, n, d);
+	}
+	d->n_count++;
+}
+
+static uint32_t
+count_leaves(const desktop_t *d)
+{
+	uint32_t n = 0;
+	for (node_t *l = d->first_leaf; l != NULL; l = l->next_leaf) {
+		n++;
+	}
+	return n;
+}
+
+/* requests and round trips per switch between a and b. the first
+ * round sets the borders tile() would have set already */
+static void
+switch_requests(desktop_t *a, desktop_t *b, uint32_t *n, uint32_t *rt)
+{
+	for (int r = 0; r <= ROUNDS; r++) {
+		if (r == 1)
+			sent = waited = 0;
+		if (show_windows(b) != 0 || hide_windows(a) != 0 ||
+			show_windows(a) != 0 || hide_windows(b) != 0)
+			fail("switch");
+	}
+	*n	= sent / (2 * ROUNDS);
+	*rt = waited / (2 * ROUNDS);
+}
+
+/* the first window of batch b */
+static int
+first_of(int b)
+{
+	return b * WINDOWS / BATCHES;
+}
+
+static void
+report(const char *phase, const double *batch, int n, int per_batch)
+{
+	printf("%-8s", phase);
+	for (int i = 0; i < n; i++) {
+		printf(" %10.0f", batch[i] / per_batch);
+	}
+	printf("   ns/op\n");
+}
+
+int
+main(void)
+{
+	static xcb_window_t order[WINDOWS * 2];
+	double				batch[BATCHES];
+	double				t0;
+
+	init_monitor();
+	desktop_t *first = mon.desktops[0];
+
+	/* windows are split breadth first, the window to split next is
+	 * looked up through the registry like a new window under the
+	 * cursor would be */
+	int head = 0, tail = 0;
+	for (int b = 0; b < BATCHES; b++) {
+		t0 = now_ns();
+		for (int i = first_of(b); i < first_of(b + 1); i++) {
+			const xcb_window_t win = (xcb_window_t)(0x400000 + i);
+			const xcb_window_t at  = (i == 0) ? XCB_NONE : order[head++];
+			open_window(first, win, at);
+			if (at != XCB_NONE)
+				order[tail++] = at;
+			order[tail++] = win;
+		}
+		batch[b] = now_ns() - t0;
+	}
+	report("open", batch, BATCHES, WINDOWS / BATCHES);
+	if (first->n_count != WINDOWS || count_leaves(first) != WINDOWS)
+		fail("window count after open");
+
+	/* desktop i keeps the windows whose number is i modulo DESKTOPS */
+	for (int b = 0; b < BATCHES; b++) {
+		t0 = now_ns();
+		for (int i = first_of(b); i < first_of(b + 1); i++) {
+			under_cursor = (xcb_window_t)(0x400000 + i);
+			if (transfer_node_wrapper(&(arg_t){.idx = i % DESKTOPS}) != 0)
+				fail("transfer");
+		}
+		batch[b] = now_ns() - t0;
+	}
+	report("spread", batch, BATCHES, WINDOWS / BATCHES);
+	for (uint32_t i = 0; i < DESKTOPS; i++) {
+		const desktop_t *d = mon.desktops[i];
+		if (d->n_count != WINDOWS / DESKTOPS ||
+			count_leaves(d) != WINDOWS / DESKTOPS)
+			fail("window count after spread");
+	}
+
+	for (int b = 0; b < BATCHES; b++) {
+		t0 = now_ns();
+		for (int r = 0; r < ROUNDS / BATCHES; r++) {
+			for (uint32_t i = 0; i < DESKTOPS; i++) {
+				desktop_t *from = mon.focused_desktop;
+				desktop_t *to	= mon.desktops[i];
+				if (show_windows(to) != 0 || render_tree(to) != 0 ||
+					hide_windows(from) != 0)
+					fail("switch");
+				from->is_focused		= false;
+				to->is_focused			= true;
+				mon.focused_desktop_idx = i;
+				mon.focused_desktop		= to;
+			}
+		}
+		batch[b] = now_ns() - t0;
+	}
+	report("switch", batch, BATCHES, DESKTOPS * ROUNDS / BATCHES);
+
+	for (int b = 0; b < BATCHES; b++) {
+		t0 = now_ns();
+		for (int i = first_of(b); i < first_of(b + 1); i++) {
+			const xcb_window_t win = (xcb_window_t)(0x400000 + i);
+			desktop_t		  *d   = NULL;
+			node_t			  *n   = registry_lookup(win, NULL, &d);
+			if (n == NULL || d != mon.desktops[i % DESKTOPS])
+				fail("lookup before close");
+			delete_node(n, d);
+		}
+		batch[b] = now_ns() - t0;
+	}
+	report("close", batch, BATCHES, WINDOWS / BATCHES);
+
+	/* layout is left out of the switch, it sends the same either way */
+	desktop_t *a = mon.desktops[0], *b = mon.desktops[1];
+	for (int i = 0; i < SWITCHED; i++) {
+		const xcb_window_t wa = (xcb_window_t)(0x800000 + i);
+		const xcb_window_t wb = wa + SWITCHED;
+		open_window(a, wa, i == 0 ? XCB_NONE : wa - 1);
+		open_window(b, wb, i == 0 ? XCB_NONE : wb - 1);
+	}
+	uint32_t was_sent, was_waited, now_sent, now_waited;
+	checked = true;
+	switch_requests(a, b, &was_sent, &was_waited);
+	checked = false;
+	switch_requests(a, b, &now_sent, &now_waited);
+	printf("%-8s %10u per switch, %u waited on\n",
+		   "checked",
+		   was_sent,
+		   was_waited);
+	printf("%-8s %10u per switch, %u waited on\n",
+		   "requests",
+		   now_sent,
+		   now_waited);
+	if (now_sent == 0 || now_sent >= was_sent || now_waited != 0)
+		fail("switch requests");
+	for (int i = 0; i < 2 * SWITCHED; i++) {
+		const xcb_window_t win = (xcb_window_t)(0x800000 + i);
+		desktop_t		  *d   = NULL;
+		node_t			  *n   = registry_lookup(win, NULL, &d);
+		if (n == NULL)
+			fail("lookup before close");
+		delete_node(n, d);
+	}
+	for (uint32_t i = 0; i < DESKTOPS; i++) {
+		desktop_t *d = mon.desktops[i];
+		if (d->n_count != 0 || d->tree != NULL || d->first_leaf != NULL ||
+			d->node_pool.n_live != 0 || d->client_pool.n_live != 0)
+			fail("leftovers after close");
+		free_tree(d);
+		free(d);
+	}
+	free(mon.desktops);
+	registry_free();
+
+	printf("%d windows over %d desktops, counters consistent\n",
+		   WINDOWS,
+		   DESKTOPS);
+	return 0;
+}
@@ -0,0 +1,173 @@
+/*
+ * BSD 2-Clause License
+ * Copyright (c) 2024, Yazeed Alharthi
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *	1. Redistributions of source code must retain the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer.
+ *
+ *	2. Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Compares layout_default() over the pointer tree (node_t) with the
+ * same pass over the compact, index-based tree (ctree_t) at 10, 100 and
+ * 1000 leaves, and checks both give the same rectangles. Splits mix
+ * ratios and orientations so the per-node split is exercised. Run with
+ * `make bench-tree`.
+ *
+ * Nodes are allocated with unrelated heap allocations in between, the
+ * way a long running session scatters them, so the pointer walk pays
+ * for the cache misses it would pay in zwm.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_util.h"
+#include "ctree.h"
+#include "layout.h"
+#include "type.h"
+
+static void		 *filler[1 << 14];
+static int		  n_filler = 0;
+static client_t	  clients[1024];
+
+static const layout_params_t params = {
+	.window_gap	  = W_GAP,
+	.border_width = BORDER_WIDTH,
+	.master_ratio = MASTER_RATIO,
+};
+
+static const rectangle_t area = {0, 0, 3840, 2160};
+
+static void
+scatter(void)
+{
+	if (n_filler < (int)(sizeof(filler) / sizeof(*filler))) {
+		filler[n_filler++] = malloc(16 + (size_t)(rand() % 512));
+	}
+}
+
+/* gives the internal nodes mixed orientations and ratios, so the
+ * per-node split is exercised rather than the defaults */
+static void
+vary_splits(node_t *n, int *i)
+{
+	static const split_type_t types[] = {
+		DYNAMIC_TYPE, VERTICAL_TYPE, HORIZONTAL_TYPE};
+
+	if (n->first_child == NULL && n->second_child == NULL)
+		return;
+	++*i;
+	n->split_type  = types[*i % 3];
+	n->split_ratio = 0.3 + 0.1 * (*i % 5);
+	vary_splits(n->first_child, i);
+	vary_splits(n->second_child, i);
+}
+
+static int
+same_layout(const ctree_t *t)
+{
+	for (uint32_t i = 0; i < t->len; i++) {
+		const rectangle_t a = t->hot[i].rectangle;
+		const rectangle_t b = t->cold[i].node->rectangle;
+		if (a.x != b.x || a.y != b.y || a.width != b.width ||
+			a.height != b.height)
+			return 0;
+	}
+	return 1;
+}
+
+static void
+run(int leaves, bool balanced)
+{
+	node_t		*root  = bench_build_tree(leaves, balanced, clients);
+	ctree_t		 t	   = {0};
+	const int	 iters = 2000000 / leaves;
+	const double scale = 1.0 / iters;
+	double		 t0, ptr, build, sweep;
+	int			 splits = 0;
+
+	vary_splits(root, &splits);
+
+	t0 = bench_now_ns();
+	for (int i = 0; i < iters; i++) {
+		layout_default(root, area, &params);
+	}
+	ptr = (bench_now_ns() - t0) * scale;
+
+	t0 = bench_now_ns();
+	for (int i = 0; i < iters; i++) {
+		ctree_build(&t, root);
+	}
+	build = (bench_now_ns() - t0) * scale;
+
+	t0 = bench_now_ns();
+	for (int i = 0; i < iters; i++) {
+		t.hot[0].rectangle = layout_root_rect(area, &params);
+		ctree_default_layout(&t, &params);
+	}
+	sweep = (bench_now_ns() - t0) * scale;
+
+	if (!same_layout(&t)) {
+		fprintf(stderr, "layouts differ at %d leaves\n", leaves);
+		exit(EXIT_FAILURE);
+	}
+
+	printf("%-8s %6d %12.0f %12.0f %12.0f %12.0f\n",
+		   balanced ? "balanced" : "spiral",
+		   leaves,
+		   ptr,
+		   sweep,
+		   build,
+		   build + sweep);
+	ctree_free(&t);
+	bench_free_nodes(root);
+}
+
+int
+main(void)
+{
+	const int sizes[] = {10, 100, 1000};
+
+	srand(1);
+	bench_on_alloc = scatter;
+	printf("%-8s %6s %12s %12s %12s %12s\n",
+		   "shape",
+		   "leaves",
+		   "pointer ns",
+		   "ctree ns",
+		   "build ns",
+		   "build+ctree");
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+		run(sizes[i], false);
+		run(sizes[i], true);
+	}
+
+	for (int i = 0; i < n_filler; i++) {
+		free(filler[i]);
+	}
+	return 0;
+}
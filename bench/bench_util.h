@@ -0,0 +1,147 @@
+/*
+ * BSD 2-Clause License
+ * Copyright (c) 2024, Yazeed Alharthi
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *	1. Redistributions of source code must retain the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer.
+ *
+ *	2. Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Synthetic trees shared by the benchmarks. Nodes are set up the way
+ * tree.c sets them up, without a desktop, pools or an X connection, and
+ * are left for the caller to lay out.
+ */
+
+#ifndef ZWM_BENCH_UTIL_H
+#define ZWM_BENCH_UTIL_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "type.h"
+
+/* called before every node allocation when set; bench_tree uses it to
+ * scatter nodes over the heap the way a long session does */
+static void (*bench_on_alloc)(void) = NULL;
+
+static inline node_t *
+bench_new_node(node_t *parent)
+{
+	if (bench_on_alloc != NULL)
+		bench_on_alloc();
+
+	node_t *n = calloc(1, sizeof(node_t));
+	if (n == NULL) {
+		perror("calloc");
+		exit(EXIT_FAILURE);
+	}
+	n->parent	   = parent;
+	n->node_type   = parent == NULL ? ROOT_NODE : EXTERNAL_NODE;
+	n->split_type  = DYNAMIC_TYPE;
+	n->split_ratio = SPLIT_RATIO;
+	return n;
+}
+
+/* leaf i holds clients[i]. leaves are split breadth first when
+ * balanced, otherwise always the newest one, which gives the dwindling
+ * spiral of a default session */
+static inline node_t *
+bench_build_tree(int leaves, bool balanced, client_t *clients)
+{
+	node_t **queue = malloc(sizeof(node_t *) * (size_t)leaves * 2);
+	int		 head = 0, tail = 0;
+	node_t	*root = bench_new_node(NULL);
+
+	if (queue == NULL) {
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+	root->client  = &clients[0];
+	queue[tail++] = root;
+	for (int i = 1; i < leaves; i++) {
+		node_t *leaf = balanced ? queue[head++] : queue[tail - 1];
+		leaf->first_child			= bench_new_node(leaf);
+		leaf->first_child->client	= leaf->client;
+		leaf->second_child			= bench_new_node(leaf);
+		leaf->second_child->client	= &clients[i];
+		leaf->client				= NULL;
+		if (leaf->parent != NULL)
+			leaf->node_type = INTERNAL_NODE;
+		queue[tail++] = leaf->first_child;
+		queue[tail++] = leaf->second_child;
+	}
+	free(queue);
+	return root;
+}
+
+static inline void
+bench_thread(node_t *n, node_t **prev, node_t **first)
+{
+	if (n->first_child == NULL && n->second_child == NULL) {
+		n->prev_leaf = *prev;
+		if (*prev != NULL)
+			(*prev)->next_leaf = n;
+		else
+			*first = n;
+		*prev = n;
+		return;
+	}
+	bench_thread(n->first_child, prev, first);
+	bench_thread(n->second_child, prev, first);
+}
+
+/* links the leaves left to right through prev_leaf and next_leaf the
+ * way tree.c keeps them; returns the first and stores the last */
+static inline node_t *
+bench_thread_leaves(node_t *root, node_t **last)
+{
+	node_t *first = NULL;
+	*last		  = NULL;
+	bench_thread(root, last, &first);
+	return first;
+}
+
+static inline void
+bench_free_nodes(node_t *n)
+{
+	if (n == NULL)
+		return;
+	bench_free_nodes(n->first_child);
+	bench_free_nodes(n->second_child);
+	free(n);
+}
+
+static inline double
+bench_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+#endif // ZWM_BENCH_UTIL_H
@@ -0,0 +1,182 @@
+/*
+ * BSD 2-Clause License
+ * Copyright (c) 2024, Yazeed Alharthi
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *	1. Redistributions of source code must retain the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer.
+ *
+ *	2. Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ctree.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "helper.h"
+#include "layout.h"
+#include "type.h"
+
+/*
+ * Compact mirror of a desktop's BSP tree. node_t stays the owner of the
+ * tree; ctree_build() copies it into two index-addressed arrays reused
+ * between passes, so a layout pass runs front to back over contiguous
+ * memory instead of chasing pointers.
+ *
+ * Only bench_tree uses it. The sweep beats the pointer walk, but not
+ * once the rebuild after every tree change is paid for, so zwm keeps
+ * laying out node_t directly.
+ */
+
+static int
+reserve(ctree_t *t, uint32_t n)
+{
+	if (n <= t->cap)
+		return 0;
+
+	uint32_t cap = t->cap ? t->cap : (2 << 4);
+	while (cap < n) {
+		cap <<= 1;
+	}
+
+	cnode_t *hot = realloc(t->hot, cap * sizeof(cnode_t));
+	if (hot == NULL)
+		return -1;
+	t->hot = hot;
+
+	cnode_cold_t *cold = realloc(t->cold, cap * sizeof(cnode_cold_t));
+	if (cold == NULL)
+		return -1;
+	t->cold = cold;
+
+	t->cap = cap;
+	return 0;
+}
+
+static uint32_t
+append(ctree_t *t, node_t *n, uint32_t parent)
+{
+	const uint32_t i = t->len++;
+	uint8_t		   f = 0;
+
+	if (n->client != NULL) {
+		if (IS_FLOATING(n->client))
+			f |= CNODE_FLOATING;
+		if (IS_FULLSCREEN(n->client))
+			f |= CNODE_FULLSCREEN;
+	}
+	if (n->is_focused)
+		f |= CNODE_FOCUSED;
+	if (n->is_master)
+		f |= CNODE_MASTER;
+
+	t->hot[i] = (cnode_t){.split_ratio	= n->split_ratio,
+						  .rectangle	= n->rectangle,
+						  .parent		= parent,
+						  .first_child	= CTREE_NONE,
+						  .second_child = CTREE_NONE,
+						  .flags		= f,
+						  .split_type	= (uint8_t)n->split_type};
+	t->cold[i] =
+		(cnode_cold_t){.floating_rectangle = n->floating_rectangle,
+					   .node			   = n};
+	return i;
+}
+
+/* the arrays double as the breadth-first queue, so building needs no
+ * extra stack */
+int
+ctree_build(ctree_t *t, node_t *root)
+{
+	t->len = 0;
+	if (root == NULL)
+		return 0;
+
+	if (reserve(t, 1) != 0) {
+		_LOG_(ERROR, "cannot allocate compact tree");
+		return -1;
+	}
+	append(t, root, CTREE_NONE);
+
+	for (uint32_t i = 0; i < t->len; i++) {
+		node_t *n = t->cold[i].node;
+		if (n->first_child == NULL && n->second_child == NULL)
+			continue;
+
+		if (reserve(t, t->len + 2) != 0) {
+			_LOG_(ERROR, "cannot allocate compact tree");
+			return -1;
+		}
+		if (n->first_child != NULL)
+			t->hot[i].first_child = append(t, n->first_child, i);
+		if (n->second_child != NULL)
+			t->hot[i].second_child = append(t, n->second_child, i);
+	}
+	return 0;
+}
+
+/* same split as layout_default(), each node's ratio and orientation
+ * included; the root rectangle must already be set. parents come
+ * first, so one forward sweep lays out the tree */
+void
+ctree_default_layout(ctree_t *t, const layout_params_t *p)
+{
+	cnode_t			   *hot	 = t->hot;
+	const cnode_cold_t *cold = t->cold;
+	const uint32_t		len	 = t->len;
+
+	for (uint32_t i = 0; i < len; i++) {
+		const uint32_t a = hot[i].first_child;
+		const uint32_t b = hot[i].second_child;
+		if (a == CTREE_NONE || b == CTREE_NONE)
+			continue;
+
+		const rectangle_t pr = hot[i].rectangle;
+		rectangle_t		  r, r2;
+		layout_split_rect(pr,
+						  (split_type_t)hot[i].split_type,
+						  hot[i].split_ratio,
+						  p,
+						  &r,
+						  &r2);
+
+		const bool fa = hot[a].flags & CNODE_FLOATING;
+		const bool fb = hot[b].flags & CNODE_FLOATING;
+		if (fa || fb) {
+			r  = fb ? pr : cold[a].floating_rectangle;
+			r2 = fa ? pr : cold[b].floating_rectangle;
+		}
+		hot[a].rectangle = r;
+		hot[b].rectangle = r2;
+	}
+}
+
+void
+ctree_free(ctree_t *t)
+{
+	free(t->hot);
+	free(t->cold);
+	*t = (ctree_t){0};
+}
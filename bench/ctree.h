@@ -0,0 +1,79 @@
+/*
+ * BSD 2-Clause License
+ * Copyright (c) 2024, Yazeed Alharthi
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *	1. Redistributions of source code must retain the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer.
+ *
+ *	2. Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ZWM_CTREE_H
+#define ZWM_CTREE_H
+
+#include "type.h"
+
+#define CTREE_NONE UINT32_MAX
+
+typedef enum {
+	CNODE_FLOATING	 = 1 << 0,
+	CNODE_FULLSCREEN = 1 << 1,
+	CNODE_FOCUSED	 = 1 << 2,
+	CNODE_MASTER	 = 1 << 3
+} cnode_flag_t;
+
+/* the part of a node that layout and traversal passes touch, kept small
+ * so a whole desktop fits in a few cache lines. children are indices
+ * into the same array, CTREE_NONE when absent */
+typedef struct {
+	double		split_ratio;
+	rectangle_t rectangle;
+	uint32_t	parent;
+	uint32_t	first_child;
+	uint32_t	second_child;
+	uint8_t		flags;
+	uint8_t		split_type;
+} cnode_t;
+
+/* the rarely needed rest, at the same index as its cnode_t */
+typedef struct {
+	rectangle_t floating_rectangle;
+	node_t	   *node;
+} cnode_cold_t;
+
+/* a desktop tree flattened breadth first into two parallel arrays, so a
+ * parent always comes before its children */
+typedef struct {
+	cnode_t		 *hot;
+	cnode_cold_t *cold;
+	uint32_t	  len;
+	uint32_t	  cap;
+} ctree_t;
+
+// clang-format off
+int  ctree_build(ctree_t *t, node_t *root);
+void ctree_default_layout(ctree_t *t, const layout_params_t *p);
+void ctree_free(ctree_t *t);
+// clang-format on
+#endif // ZWM_CTREE_H
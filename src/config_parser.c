@@ -78,6 +78,7 @@ static conf_mapper_t _cmapper_[] = {
  	{"kill", 		    close_or_kill_wrapper}, 
  	{"switch_desktop", switch_desktop_wrapper}, 
  	{"resize", 		horizontal_resize_wrapper}, 
+ 	{"vertical_resize", vertical_resize_wrapper}, 
  	{"fullscreen", 	   set_fullscreen_wrapper}, 
  	{"swap", 				swap_node_wrapper}, 
  	{"transfer_node", 	transfer_node_wrapper}, 
@@ -709,7 +710,8 @@ set_key_args(conf_key_t *key, char *func, char *arg)
 		} else if (strcmp(arg, "right") == 0) {
 			key->arg->d = RIGHT;
 		}
-	} else if (strcmp(func, "resize") == 0) {
+	} else if (strcmp(func, "resize") == 0 ||
+			   strcmp(func, "vertical_resize") == 0) {
 		if (strcmp(arg, "grow") == 0) {
 			key->arg->r = GROW;
 		} else if (strcmp(arg, "shrink") == 0) {
@@ -1058,23 +1060,18 @@ construct_rule(char *class,
 }
 
 rule_t *
-get_window_rule(xcb_window_t win)
+get_window_rule(const char *class_name)
 {
-	xcb_icccm_get_wm_class_reply_t t_reply;
-	xcb_get_property_cookie_t	   cn =
-		xcb_icccm_get_wm_class(wm->connection, win);
-	const uint8_t wr =
-		xcb_icccm_get_wm_class_reply(wm->connection, cn, &t_reply, NULL);
-	if (wr == 1) {
-		rule_t *current = rule_head;
-		while (current != NULL) {
-			if (strcasecmp(current->win_name, t_reply.class_name) == 0) {
-				xcb_icccm_get_wm_class_reply_wipe(&t_reply);
-				return current;
-			}
-			current = current->next;
+	if (class_name == NULL || class_name[0] == '\0') {
+		return NULL;
+	}
+
+	rule_t *current = rule_head;
+	while (current != NULL) {
+		if (strcasecmp(current->win_name, class_name) == 0) {
+			return current;
 		}
-		xcb_icccm_get_wm_class_reply_wipe(&t_reply);
+		current = current->next;
 	}
 	return NULL;
 }
@@ -41,7 +41,7 @@ extern rule_t	  *rule_head;
 extern conf_key_t *key_head;
 
 // clang-format off
-rule_t *get_window_rule(xcb_window_t win);
+rule_t *get_window_rule(const char *class_name);
 int     load_config(config_t *c);
 void    free_keys(void);
 void    free_rules(void);
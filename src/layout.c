@@ -0,0 +1,518 @@
+/*
+ * BSD 2-Clause License
+ * Copyright (c) 2024, Yazeed Alharthi
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *	1. Redistributions of source code must retain the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer.
+ *
+ *	2. Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "layout.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "helper.h"
+#include "type.h"
+
+/*
+ * Window geometry for the tiling layouts. Everything here works on a
+ * tree or its leaf sequence, the area it may cover and a
+ * layout_params_t, and writes node rectangles; nothing reads the
+ * monitors, the bar or the config, and nothing talks to the X server.
+ * Callers work out the area from the monitor a desktop is on and push
+ * the rectangles out when rendering.
+ */
+
+/* a dynamic split puts the parts side by side when the rectangle is
+ * wider than tall and one above the other otherwise */
+static bool
+side_by_side(const rectangle_t *r, split_type_t t)
+{
+	if (t == DYNAMIC_TYPE)
+		return r->width >= r->height;
+	return t == VERTICAL_TYPE;
+}
+
+static bool
+is_side_by_side(const node_t *n)
+{
+	return side_by_side(&n->rectangle, n->split_type);
+}
+
+/* divides r along a split of type t, the first part taking ratio of
+ * it, with a gap between the two parts */
+void
+layout_split_rect(rectangle_t			 r,
+				  split_type_t			 t,
+				  double				 ratio,
+				  const layout_params_t *p,
+				  rectangle_t			*a,
+				  rectangle_t			*b)
+{
+	const uint16_t gap = p->window_gap;
+	const uint16_t bw  = p->border_width;
+
+	if (side_by_side(&r, t)) {
+		a->x	  = r.x;
+		a->y	  = r.y;
+		a->width  = (uint16_t)((r.width - (gap - bw)) * ratio);
+		a->height = r.height;
+
+		b->x	  = (int16_t)(r.x + a->width + gap + bw);
+		b->y	  = r.y;
+		b->width  = r.width - a->width - gap - bw;
+		b->height = r.height;
+	} else {
+		a->x	  = r.x;
+		a->y	  = r.y;
+		a->width  = r.width;
+		a->height = (uint16_t)((r.height - (gap - bw)) * ratio);
+
+		b->x	  = r.x;
+		b->y	  = (int16_t)(r.y + a->height + gap + bw);
+		b->width  = r.width;
+		b->height = r.height - a->height - gap - bw;
+	}
+}
+
+static void
+split_rect(const node_t			 *n,
+		   const layout_params_t *p,
+		   rectangle_t			 *a,
+		   rectangle_t			 *b)
+{
+	layout_split_rect(
+		n->rectangle, n->split_type, n->split_ratio, p, a, b);
+}
+
+static bool
+is_floating_leaf(const node_t *n)
+{
+	return n->client != NULL && IS_FLOATING(n->client);
+}
+
+rectangle_t
+layout_work_area(rectangle_t monitor, uint16_t bar_height)
+{
+	return (rectangle_t){
+		.x		= monitor.x,
+		.y		= (int16_t)(monitor.y + bar_height),
+		.width	= monitor.width,
+		.height = (uint16_t)(monitor.height - bar_height),
+	};
+}
+
+rectangle_t
+layout_root_rect(rectangle_t area, const layout_params_t *p)
+{
+	const uint16_t gap = p->window_gap;
+	const uint16_t bw  = p->border_width;
+
+	return (rectangle_t){
+		.x		= (int16_t)(area.x + gap),
+		.y		= (int16_t)(area.y + gap),
+		.width	= (uint16_t)(area.width - 2 * gap - 2 * bw),
+		.height = (uint16_t)(area.height - 2 * gap - 2 * bw),
+	};
+}
+
+void
+layout_resize_subtree(node_t *n, const layout_params_t *p)
+{
+	if (n == NULL)
+		return;
+
+	rectangle_t r, r2 = {0};
+	split_rect(n, p, &r, &r2);
+
+	if (n->first_child != NULL) {
+		n->first_child->rectangle = r;
+		if (IS_INTERNAL(n->first_child)) {
+			layout_resize_subtree(n->first_child, p);
+		}
+	}
+
+	if (n->second_child != NULL) {
+		n->second_child->rectangle = r2;
+		if (IS_INTERNAL(n->second_child)) {
+			layout_resize_subtree(n->second_child, p);
+		}
+	}
+}
+
+/* a floating child keeps its own rectangle and leaves the whole of its
+ * parent to the other child */
+static void
+split_default(node_t *n, const layout_params_t *p)
+{
+	rectangle_t r, r2 = {0};
+	split_rect(n, p, &r, &r2);
+
+	if (n->first_child != NULL) {
+		n->first_child->rectangle =
+			is_floating_leaf(n->second_child) ? n->rectangle
+			: is_floating_leaf(n->first_child)
+				? n->first_child->floating_rectangle
+				: r;
+	}
+
+	if (n->second_child != NULL) {
+		n->second_child->rectangle =
+			is_floating_leaf(n->first_child) ? n->rectangle
+			: is_floating_leaf(n->second_child)
+				? n->second_child->floating_rectangle
+				: r2;
+	}
+}
+
+void
+layout_default_subtree(node_t *n, const layout_params_t *p)
+{
+	if (n == NULL)
+		return;
+
+	if (n->first_child == NULL && n->second_child == NULL) {
+		return;
+	}
+
+	split_default(n, p);
+	if (n->first_child != NULL && IS_INTERNAL(n->first_child)) {
+		layout_default_subtree(n->first_child, p);
+	}
+	if (n->second_child != NULL && IS_INTERNAL(n->second_child)) {
+		layout_default_subtree(n->second_child, p);
+	}
+}
+
+void
+layout_default(node_t *root, rectangle_t area, const layout_params_t *p)
+{
+	if (root == NULL)
+		return;
+
+	root->rectangle = layout_root_rect(area, p);
+	layout_default_subtree(root, p);
+}
+
+/* the master takes the left master_ratio of the area and the rest of
+ * the windows stack on the right */
+static void
+master_area(rectangle_t			   area,
+			const layout_params_t *p,
+			rectangle_t			  *master,
+			rectangle_t			  *rest)
+{
+	const uint16_t gap			= p->window_gap;
+	const uint16_t master_width = (uint16_t)(area.width * p->master_ratio);
+	const uint16_t r_width =
+		(uint16_t)(area.width * (1 - p->master_ratio));
+
+	*master = (rectangle_t){
+		.x		= (int16_t)(area.x + gap),
+		.y		= (int16_t)(area.y + gap),
+		.width	= (uint16_t)(master_width - 2 * gap),
+		.height = (uint16_t)(area.height - 2 * gap),
+	};
+
+	*rest = (rectangle_t){
+		.x		= (int16_t)(area.x + master_width),
+		.y		= (int16_t)(area.y + gap),
+		.width	= (uint16_t)(r_width - gap),
+		.height = (uint16_t)(area.height - 2 * gap),
+	};
+}
+
+/* part i of k equal parts of len with space between neighbours. the
+ * pixels that do not divide evenly go one each to the first parts, so
+ * the parts and the space between them add up to len exactly */
+static void
+span(int32_t len, uint32_t k, uint32_t i, int32_t space, int32_t *off,
+	 int32_t *size)
+{
+	int32_t avail = len - (int32_t)(k - 1) * space;
+	if (avail < (int32_t)k)
+		avail = (int32_t)k;
+
+	const int32_t base	= avail / (int32_t)k;
+	const int32_t extra = avail % (int32_t)k;
+	const int32_t j		= (int32_t)i;
+	*off				= j * (base + space) + (j < extra ? j : extra);
+	*size				= base + (j < extra ? 1 : 0);
+}
+
+/* rows of k equal rectangles filling r from the top, and columns of
+ * them from the left */
+static rectangle_t
+row_of(rectangle_t r, uint32_t k, uint32_t i, int32_t space)
+{
+	int32_t off, size;
+	span(r.height, k, i, space, &off, &size);
+	r.y		 = (int16_t)(r.y + off);
+	r.height = (uint16_t)size;
+	return r;
+}
+
+static rectangle_t
+column_of(rectangle_t r, uint32_t k, uint32_t i, int32_t space)
+{
+	int32_t off, size;
+	span(r.width, k, i, space, &off, &size);
+	r.x		= (int16_t)(r.x + off);
+	r.width = (uint16_t)size;
+	return r;
+}
+
+static uint32_t
+count_tiled(const node_t *first)
+{
+	uint32_t n = 0;
+	for (const node_t *l = first; l != NULL; l = l->next_leaf) {
+		if (!is_floating_leaf(l))
+			n++;
+	}
+	return n;
+}
+
+/* the master and a column of equal rows beside it for the rest, or the
+ * whole area for a master on its own */
+static void
+flat_master(node_t				  *first,
+			node_t				  *master,
+			rectangle_t			   area,
+			const layout_params_t *p,
+			leaf_visit_t		   visit,
+			void				  *arg)
+{
+	const int32_t  space = p->window_gap + 2 * p->border_width;
+	const uint32_t tiled = count_tiled(first);
+	rectangle_t	   m	 = layout_root_rect(area, p);
+	rectangle_t	   rest	 = {0};
+	uint32_t	   i	 = 0;
+
+	if (master == NULL || is_floating_leaf(master)) {
+		for (master = first; master != NULL; master = master->next_leaf) {
+			if (!is_floating_leaf(master))
+				break;
+		}
+	}
+	if (tiled > 1) {
+		master_area(area, p, &m, &rest);
+	}
+
+	for (node_t *l = first; l != NULL; l = l->next_leaf) {
+		if (is_floating_leaf(l)) {
+			l->rectangle = l->floating_rectangle;
+		} else if (l == master) {
+			l->rectangle = m;
+		} else {
+			l->rectangle = row_of(rest, tiled - 1, i++, space);
+		}
+		if (visit != NULL)
+			visit(l, arg);
+	}
+}
+
+/* every window covers the whole area, the one on top is the one seen */
+static void
+flat_stack(node_t				 *first,
+		   rectangle_t			  area,
+		   const layout_params_t *p,
+		   leaf_visit_t			  visit,
+		   void					 *arg)
+{
+	const rectangle_t r = layout_root_rect(area, p);
+
+	for (node_t *l = first; l != NULL; l = l->next_leaf) {
+		l->rectangle = is_floating_leaf(l) ? l->floating_rectangle : r;
+		if (visit != NULL)
+			visit(l, arg);
+	}
+}
+
+/* as many columns as the square root of the window count rounded up
+ * and as many rows as needed, the last row sharing its width among
+ * fewer windows when they do not fill it */
+static void
+flat_grid(node_t				*first,
+		  rectangle_t			 area,
+		  const layout_params_t *p,
+		  leaf_visit_t			 visit,
+		  void					*arg)
+{
+	const int32_t	  space = p->window_gap + 2 * p->border_width;
+	const uint32_t	  tiled = count_tiled(first);
+	const rectangle_t r		= layout_root_rect(area, p);
+	uint32_t		  cols	= 1;
+	uint32_t		  i		= 0;
+
+	while (cols * cols < tiled) {
+		cols++;
+	}
+	const uint32_t rows = tiled == 0 ? 1 : (tiled + cols - 1) / cols;
+
+	for (node_t *l = first; l != NULL; l = l->next_leaf) {
+		if (is_floating_leaf(l)) {
+			l->rectangle = l->floating_rectangle;
+		} else {
+			const uint32_t row	  = i / cols;
+			const uint32_t in_row = row == rows - 1 ? tiled - row * cols
+													: cols;
+			l->rectangle		  = column_of(row_of(r, rows, row, space),
+											  in_row,
+											  i % cols,
+											  space);
+			i++;
+		}
+		if (visit != NULL)
+			visit(l, arg);
+	}
+}
+
+/* the master, stack and grid layouts depend only on the order of the
+ * leaves, not on the shape of the tree above them: one pass over the
+ * leaf sequence from first places every window and hands it to visit
+ * when that is not NULL */
+void
+layout_flat(layout_t			   t,
+			node_t				  *first,
+			node_t				  *master,
+			rectangle_t			   area,
+			const layout_params_t *p,
+			leaf_visit_t		   visit,
+			void				  *arg)
+{
+	switch (t) {
+	case MASTER: flat_master(first, master, area, p, visit, arg); break;
+	case STACK: flat_stack(first, area, p, visit, arg); break;
+	case GRID: flat_grid(first, area, p, visit, arg); break;
+	case DEFAULT: break;
+	}
+}
+
+/* clears the marks a layout_flat() pass leaves behind, going down only
+ * where something is marked */
+void
+layout_clear_dirty(node_t *n)
+{
+	if (n == NULL || !(n->is_dirty || n->is_dirty_below))
+		return;
+
+	n->is_dirty		  = false;
+	n->is_dirty_below = false;
+	layout_clear_dirty(n->first_child);
+	layout_clear_dirty(n->second_child);
+}
+
+/* turns a side by side split of n's parent into one above the other
+ * and back. the parent has to be laid out again afterwards */
+void
+layout_flip(node_t *n)
+{
+	node_t *parent = n->parent;
+	if (parent == NULL)
+		return;
+
+	parent->split_type =
+		is_side_by_side(parent) ? HORIZONTAL_TYPE : VERTICAL_TYPE;
+}
+
+/* moves the split of the nearest ancestor of n that divides along axis
+ * by px, so the side holding n grows, or shrinks when px is negative.
+ * returns that ancestor, whose subtree has to be laid out again, or
+ * NULL when no split runs that way */
+node_t *
+layout_resize(node_t *n, split_type_t axis, int16_t px)
+{
+	node_t *c = n;
+	node_t *p = n->parent;
+	while (p != NULL && is_side_by_side(p) != (axis == VERTICAL_TYPE)) {
+		c = p;
+		p = p->parent;
+	}
+	if (p == NULL)
+		return NULL;
+
+	const uint16_t size =
+		axis == VERTICAL_TYPE ? p->rectangle.width : p->rectangle.height;
+	if (size == 0)
+		return NULL;
+
+	const double step  = (double)px / size;
+	double		 ratio = p->split_ratio +
+						 (c == p->first_child ? step : -step);
+	if (ratio < MIN_SPLIT_RATIO)
+		ratio = MIN_SPLIT_RATIO;
+	if (ratio > 1 - MIN_SPLIT_RATIO)
+		ratio = 1 - MIN_SPLIT_RATIO;
+
+	p->split_ratio = ratio;
+	return p;
+}
+
+/* one pass over what changed since the last one: subtrees under a dirty
+ * node are split again from its rectangle and every leaf in them is
+ * handed to visit, clean siblings on the way down are not entered */
+static void
+relayout(node_t				   *n,
+		 const layout_params_t *p,
+		 bool					force,
+		 leaf_visit_t			visit,
+		 void				   *arg)
+{
+	force			  = force || n->is_dirty;
+	n->is_dirty		  = false;
+	n->is_dirty_below = false;
+
+	if (n->first_child == NULL && n->second_child == NULL) {
+		if (force && n->client != NULL)
+			visit(n, arg);
+		return;
+	}
+
+	if (force) {
+		split_default(n, p);
+	}
+
+	node_t *c[] = {n->first_child, n->second_child};
+	for (int i = 0; i < 2; i++) {
+		if (c[i] == NULL)
+			continue;
+		if (force || c[i]->is_dirty || c[i]->is_dirty_below)
+			relayout(c[i], p, force, visit, arg);
+	}
+}
+
+void
+layout_dirty(node_t			   *root,
+			 const layout_params_t *p,
+			 leaf_visit_t			visit,
+			 void				   *arg)
+{
+	if (root == NULL || !(root->is_dirty || root->is_dirty_below))
+		return;
+
+	relayout(root, p, false, visit, arg);
+}
@@ -0,0 +1,49 @@
+/*
+ * BSD 2-Clause License
+ * Copyright (c) 2024, Yazeed Alharthi
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *	1. Redistributions of source code must retain the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer.
+ *
+ *	2. Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ZWM_LAYOUT_H
+#define ZWM_LAYOUT_H
+
+#include "type.h"
+// clang-format off
+rectangle_t layout_work_area(rectangle_t monitor, uint16_t bar_height);
+rectangle_t layout_root_rect(rectangle_t area, const layout_params_t *p);
+void        layout_split_rect(rectangle_t r, split_type_t t, double ratio, const layout_params_t *p, rectangle_t *a, rectangle_t *b);
+void        layout_resize_subtree(node_t *n, const layout_params_t *p);
+void        layout_default(node_t *root, rectangle_t area, const layout_params_t *p);
+void        layout_default_subtree(node_t *n, const layout_params_t *p);
+void        layout_flat(layout_t t, node_t *first, node_t *master, rectangle_t area, const layout_params_t *p, leaf_visit_t visit, void *arg);
+void        layout_clear_dirty(node_t *n);
+void        layout_flip(node_t *n);
+node_t     *layout_resize(node_t *n, split_type_t axis, int16_t px);
+void        layout_dirty(node_t *root, const layout_params_t *p, leaf_visit_t visit, void *arg);
+// clang-format on
+#endif // ZWM_LAYOUT_H
@@ -0,0 +1,193 @@
+/*
+ * BSD 2-Clause License
+ * Copyright (c) 2024, Yazeed Alharthi
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *	1. Redistributions of source code must retain the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer.
+ *
+ *	2. Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "monitor.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <xcb/randr.h>
+#include <xcb/xcb.h>
+
+#include "helper.h"
+#include "type.h"
+
+/*
+ * Table of the connected monitors, kept next to the head_monitor list
+ * so the lookups done on every enter notify and map request do not walk
+ * it. Monitors sit in an array in the order they were added.
+ *
+ * RandR output ids map to array positions through an open addressing
+ * hash kept at most half full; slots hold the position plus one, so 0
+ * marks an empty slot. Outputs set up without RandR have no id and are
+ * only reachable through the array.
+ *
+ * Point lookups scan the array, which for the dozen outputs a setup can
+ * have is a handful of compares over memory that is already cached, and
+ * try the monitor that matched last time first, since the pointer
+ * rarely changes outputs between two events.
+ */
+
+#define MONITOR_MIN_CAP (2 << 2)
+
+static monitor_t **monitors	  = NULL;
+static uint32_t	   n_monitors = 0;
+static uint32_t	   capacity	  = 0;
+static uint32_t	  *by_randr	  = NULL;
+static uint32_t	   hash_cap	  = 0;
+static uint32_t	   last_hit	  = 0;
+
+static uint32_t
+slot_of(xcb_randr_output_t id)
+{
+	uint32_t h = id;
+	h ^= h >> 16;
+	h *= 0x45d9f3b;
+	h ^= h >> 16;
+	return h & (hash_cap - 1);
+}
+
+static void
+hash_insert(uint32_t i)
+{
+	uint32_t s = slot_of(monitors[i]->randr_id);
+	while (by_randr[s] != 0) {
+		s = (s + 1) & (hash_cap - 1);
+	}
+	by_randr[s] = i + 1;
+}
+
+static int
+grow(void)
+{
+	const uint32_t new_cap = capacity ? capacity << 1 : MONITOR_MIN_CAP;
+
+	monitor_t	 **m = realloc(monitors, new_cap * sizeof(monitor_t *));
+	if (m == NULL)
+		return -1;
+	monitors = m;
+
+	uint32_t *h = calloc(new_cap * 2, sizeof(uint32_t));
+	if (h == NULL)
+		return -1;
+
+	free(by_randr);
+	by_randr = h;
+	hash_cap = new_cap * 2;
+	capacity = new_cap;
+	for (uint32_t i = 0; i < n_monitors; i++) {
+		if (monitors[i]->randr_id != XCB_NONE)
+			hash_insert(i);
+	}
+	return 0;
+}
+
+int
+monitor_table_add(monitor_t *m)
+{
+	if (n_monitors == capacity && grow() != 0) {
+		_LOG_(ERROR, "cannot grow monitor table");
+		return -1;
+	}
+
+	monitors[n_monitors] = m;
+	if (m->randr_id != XCB_NONE)
+		hash_insert(n_monitors);
+	n_monitors++;
+	return 0;
+}
+
+void
+monitor_table_clear(void)
+{
+	free(monitors);
+	free(by_randr);
+	monitors   = NULL;
+	by_randr   = NULL;
+	n_monitors = 0;
+	capacity   = 0;
+	hash_cap   = 0;
+	last_hit   = 0;
+}
+
+uint32_t
+monitor_table_len(void)
+{
+	return n_monitors;
+}
+
+monitor_t *
+monitor_table_at(uint32_t i)
+{
+	return i < n_monitors ? monitors[i] : NULL;
+}
+
+monitor_t *
+monitor_by_randr_id(xcb_randr_output_t id)
+{
+	if (hash_cap == 0 || id == XCB_NONE)
+		return NULL;
+
+	uint32_t s = slot_of(id);
+	while (by_randr[s] != 0) {
+		monitor_t *m = monitors[by_randr[s] - 1];
+		if (m->randr_id == id)
+			return m;
+		s = (s + 1) & (hash_cap - 1);
+	}
+	return NULL;
+}
+
+static bool
+contains(const monitor_t *m, int32_t x, int32_t y)
+{
+	const rectangle_t *r = &m->rectangle;
+	return x >= r->x && x < r->x + r->width && y >= r->y &&
+		   y < r->y + r->height;
+}
+
+monitor_t *
+monitor_at(int32_t x, int32_t y)
+{
+	if (n_monitors == 0)
+		return NULL;
+
+	if (last_hit < n_monitors && contains(monitors[last_hit], x, y))
+		return monitors[last_hit];
+
+	for (uint32_t i = 0; i < n_monitors; i++) {
+		if (contains(monitors[i], x, y)) {
+			last_hit = i;
+			return monitors[i];
+		}
+	}
+	return NULL;
+}
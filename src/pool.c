@@ -0,0 +1,137 @@
+/*
+ * BSD 2-Clause License
+ * Copyright (c) 2024, Yazeed Alharthi
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *	1. Redistributions of source code must retain the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer.
+ *
+ *	2. Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "pool.h"
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "helper.h"
+#include "type.h"
+
+/*
+ * Fixed-size object pools, one per desktop for its nodes and one for its
+ * clients. Memory is taken from the heap a slab of POOL_SLAB_OBJECTS at a
+ * time and released objects go onto a free list threaded through the
+ * objects themselves, so windows opening and closing all day reuse the
+ * same slots instead of fragmenting the heap. A pool is only returned to
+ * the heap as a whole, slab by slab, when its desktop goes away.
+ */
+
+#define POOL_SLAB_OBJECTS (2 << 4)
+
+/* slots and the slab header are padded to the strictest alignment so any
+ * object type can live in a pool */
+static size_t
+align_up(size_t n)
+{
+	const size_t a = alignof(max_align_t);
+	return (n + a - 1) & ~(a - 1);
+}
+
+static int
+add_slab(pool_t *p)
+{
+	const size_t head = align_up(sizeof(pool_slab_t));
+	pool_slab_t *s	  = malloc(head + p->obj_size * POOL_SLAB_OBJECTS);
+	if (s == NULL) {
+		_LOG_(ERROR, "cannot allocate pool slab");
+		return -1;
+	}
+
+	s->next	 = p->slabs;
+	p->slabs = s;
+
+	/* chain the new slots onto the free list back to front, so they are
+	 * handed out in address order */
+	uint8_t *base = (uint8_t *)s + head;
+	for (int i = POOL_SLAB_OBJECTS - 1; i >= 0; i--) {
+		void **slot	 = (void **)(base + (size_t)i * p->obj_size);
+		*slot		 = p->free_list;
+		p->free_list = slot;
+	}
+	p->n_pooled += POOL_SLAB_OBJECTS;
+	return 0;
+}
+
+void
+pool_init(pool_t *p, size_t obj_size)
+{
+	if (obj_size < sizeof(void *))
+		obj_size = sizeof(void *);
+
+	p->slabs	 = NULL;
+	p->free_list = NULL;
+	p->obj_size	 = align_up(obj_size);
+	p->n_live	 = 0;
+	p->n_pooled	 = 0;
+}
+
+void *
+pool_alloc(pool_t *p)
+{
+	if (p->free_list == NULL && add_slab(p) != 0)
+		return NULL;
+
+	void **slot	 = p->free_list;
+	p->free_list = *slot;
+	p->n_pooled--;
+	p->n_live++;
+	return slot;
+}
+
+void
+pool_release(pool_t *p, void *obj)
+{
+	if (obj == NULL)
+		return;
+
+	void **slot	 = obj;
+	*slot		 = p->free_list;
+	p->free_list = slot;
+	p->n_live--;
+	p->n_pooled++;
+}
+
+/* every object still handed out becomes invalid */
+void
+pool_destroy(pool_t *p)
+{
+	pool_slab_t *s = p->slabs;
+	while (s != NULL) {
+		pool_slab_t *next = s->next;
+		free(s);
+		s = next;
+	}
+	pool_init(p, p->obj_size);
+}
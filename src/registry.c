@@ -0,0 +1,223 @@
+/*
+ * BSD 2-Clause License
+ * Copyright (c) 2024, Yazeed Alharthi
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *	1. Redistributions of source code must retain the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer.
+ *
+ *	2. Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "registry.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <xcb/xcb.h>
+
+#include "helper.h"
+#include "type.h"
+
+/*
+ * Set of the windows that are alive on the server, fed from create,
+ * map-request and destroy events, so asking whether a window still
+ * exists does not need a QueryTree round trip.
+ *
+ * Managed windows also carry the monitor, desktop and node they live
+ * in. The tree code keeps that in step whenever a client lands in a new
+ * node, so finding a window's node is a single probe wherever it is.
+ *
+ * Open addressing with linear probing; XCB_NONE marks an empty slot and
+ * removal shifts the rest of the cluster back instead of leaving
+ * tombstones, so lookups never scan more than one cluster.
+ */
+
+#define REGISTRY_MIN_CAP (2 << 5)
+
+static registry_entry_t *table	  = NULL;
+static uint32_t			 capacity = 0;
+static uint32_t			 count	  = 0;
+
+static uint32_t
+slot_of(xcb_window_t win)
+{
+	uint32_t h = win;
+	h ^= h >> 16;
+	h *= 0x45d9f3b;
+	h ^= h >> 16;
+	return h & (capacity - 1);
+}
+
+static int
+grow(void)
+{
+	const uint32_t	  old_cap	= capacity;
+	registry_entry_t *old_table = table;
+	const uint32_t	  new_cap	= old_cap ? old_cap << 1 : REGISTRY_MIN_CAP;
+
+	registry_entry_t *t = calloc(new_cap, sizeof(registry_entry_t));
+	if (t == NULL) {
+		_LOG_(ERROR, "cannot allocate window registry");
+		return -1;
+	}
+
+	table	 = t;
+	capacity = new_cap;
+	for (uint32_t i = 0; i < old_cap; i++) {
+		if (old_table[i].window == XCB_NONE)
+			continue;
+		uint32_t s = slot_of(old_table[i].window);
+		while (table[s].window != XCB_NONE) {
+			s = (s + 1) & (capacity - 1);
+		}
+		table[s] = old_table[i];
+	}
+
+	free(old_table);
+	return 0;
+}
+
+static registry_entry_t *
+lookup(xcb_window_t win)
+{
+	if (capacity == 0 || win == XCB_NONE)
+		return NULL;
+
+	uint32_t s = slot_of(win);
+	while (table[s].window != XCB_NONE) {
+		if (table[s].window == win)
+			return &table[s];
+		s = (s + 1) & (capacity - 1);
+	}
+	return NULL;
+}
+
+int
+registry_add(xcb_window_t win)
+{
+	if (win == XCB_NONE)
+		return -1;
+
+	if (lookup(win) != NULL)
+		return 0;
+
+	/* keep the load factor under 3/4 */
+	if ((count + 1) * 4 > capacity * 3 && grow() != 0)
+		return -1;
+
+	uint32_t s = slot_of(win);
+	while (table[s].window != XCB_NONE) {
+		s = (s + 1) & (capacity - 1);
+	}
+	table[s] = (registry_entry_t){.window = win};
+	count++;
+	return 0;
+}
+
+int
+registry_attach(xcb_window_t win, monitor_t *m, desktop_t *d, node_t *n)
+{
+	if (registry_add(win) != 0)
+		return -1;
+
+	registry_entry_t *e = lookup(win);
+	e->monitor			= m;
+	e->desktop			= d;
+	e->node				= n;
+	return 0;
+}
+
+/* the window stays alive, it is just no longer managed */
+void
+registry_detach(xcb_window_t win)
+{
+	registry_entry_t *e = lookup(win);
+	if (e == NULL)
+		return;
+
+	e->monitor = NULL;
+	e->desktop = NULL;
+	e->node	   = NULL;
+}
+
+void
+registry_remove(xcb_window_t win)
+{
+	registry_entry_t *e = lookup(win);
+	if (e == NULL)
+		return;
+
+	uint32_t hole = (uint32_t)(e - table);
+	uint32_t s	  = hole;
+	table[hole]	  = (registry_entry_t){0};
+	count--;
+
+	/* pull back every entry of the cluster that would no longer be
+	 * reachable from its home slot through the new hole */
+	for (;;) {
+		s = (s + 1) & (capacity - 1);
+		if (table[s].window == XCB_NONE)
+			break;
+		const uint32_t home	   = slot_of(table[s].window);
+		const bool	   movable = (hole <= s)
+									 ? (home <= hole || home > s)
+									 : (home <= hole && home > s);
+		if (movable) {
+			table[hole] = table[s];
+			table[s]	= (registry_entry_t){0};
+			hole		= s;
+		}
+	}
+}
+
+bool
+registry_contains(xcb_window_t win)
+{
+	return lookup(win) != NULL;
+}
+
+/* the node holding win, or NULL when it is not managed; m and d are
+ * filled in when given */
+node_t *
+registry_lookup(xcb_window_t win, monitor_t **m, desktop_t **d)
+{
+	const registry_entry_t *e = lookup(win);
+	if (e == NULL || e->node == NULL)
+		return NULL;
+
+	if (m != NULL)
+		*m = e->monitor;
+	if (d != NULL)
+		*d = e->desktop;
+	return e->node;
+}
+
+void
+registry_free(void)
+{
+	free(table);
+	table	 = NULL;
+	capacity = 0;
+	count	 = 0;
+}
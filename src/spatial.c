@@ -0,0 +1,183 @@
+/*
+ * BSD 2-Clause License
+ * Copyright (c) 2024, Yazeed Alharthi
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *	1. Redistributions of source code must retain the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer.
+ *
+ *	2. Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spatial.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "helper.h"
+#include "type.h"
+
+/*
+ * Directional neighbour search over the leaves of a desktop. Every
+ * direction keeps the leaves sorted by the edge that faces it, so the
+ * nearest window to one side is found by a binary search for the first
+ * leaf past the edge of the focused one, followed by a walk outwards
+ * that stops at the first leaf overlapping it on the other axis. The
+ * arrays are kept per desktop, rebuilt on the first search after the
+ * layout changed and reused between rebuilds.
+ */
+
+static int
+reserve(spatial_t *s, uint32_t n)
+{
+	if (n <= s->cap)
+		return 0;
+
+	uint32_t cap = s->cap ? s->cap : (2 << 4);
+	while (cap < n) {
+		cap <<= 1;
+	}
+
+	for (int i = 0; i < SPATIAL_AXES; i++) {
+		spatial_entry_t *e =
+			realloc(s->edges[i], cap * sizeof(spatial_entry_t));
+		if (e == NULL)
+			return -1;
+		s->edges[i] = e;
+	}
+	s->cap = cap;
+	return 0;
+}
+
+static int
+cmp_entry(const void *a, const void *b)
+{
+	const int32_t ka = ((const spatial_entry_t *)a)->key;
+	const int32_t kb = ((const spatial_entry_t *)b)->key;
+	return (ka > kb) - (ka < kb);
+}
+
+/* the edges of r as seen from dir, in the layout of spatial_entry_t */
+static spatial_entry_t
+entry_of(const rectangle_t *r, direction_t dir)
+{
+	const int32_t x	 = r->x;
+	const int32_t y	 = r->y;
+	const int32_t xe = x + r->width;
+	const int32_t ye = y + r->height;
+
+	switch (dir) {
+	case LEFT: return (spatial_entry_t){-xe, y, ye, NULL};
+	case RIGHT: return (spatial_entry_t){x, y, ye, NULL};
+	case UP: return (spatial_entry_t){-ye, x, xe, NULL};
+	case DOWN:
+	default: return (spatial_entry_t){y, x, xe, NULL};
+	}
+}
+
+/* where a leaf has to start, in key space, to lie beyond r towards dir */
+static int32_t
+limit_of(const rectangle_t *r, direction_t dir)
+{
+	switch (dir) {
+	case LEFT: return -(int32_t)r->x;
+	case RIGHT: return (int32_t)r->x + r->width;
+	case UP: return -(int32_t)r->y;
+	case DOWN:
+	default: return (int32_t)r->y + r->height;
+	}
+}
+
+int
+spatial_build(spatial_t *s, const desktop_t *d)
+{
+	uint32_t n = 0;
+	for (const node_t *l = d->first_leaf; l != NULL; l = l->next_leaf) {
+		n++;
+	}
+
+	if (reserve(s, n) != 0)
+		return -1;
+
+	s->len = 0;
+	for (node_t *l = d->first_leaf; l != NULL; l = l->next_leaf) {
+		/* a root leaf is alone on its desktop and never a neighbour */
+		if (!IS_EXTERNAL(l) || l->client == NULL)
+			continue;
+		for (int a = 0; a < SPATIAL_AXES; a++) {
+			spatial_entry_t e = entry_of(&l->rectangle, LEFT + a);
+			e.node			  = l;
+			s->edges[a][s->len] = e;
+		}
+		s->len++;
+	}
+
+	for (int a = 0; a < SPATIAL_AXES; a++) {
+		qsort(s->edges[a], s->len, sizeof(spatial_entry_t), cmp_entry);
+	}
+	s->is_valid = true;
+	return 0;
+}
+
+node_t *
+spatial_nearest(desktop_t *d, const node_t *n, direction_t dir)
+{
+	if (n == NULL || dir < LEFT || dir > DOWN)
+		return NULL;
+
+	spatial_t *s = &d->spatial;
+	if (!s->is_valid && spatial_build(s, d) != 0)
+		return NULL;
+
+	const spatial_entry_t *e	 = s->edges[dir - LEFT];
+	const spatial_entry_t  self	 = entry_of(&n->rectangle, dir);
+	const int32_t		   limit = limit_of(&n->rectangle, dir);
+
+	/* first entry whose key is at least limit */
+	uint32_t lo = 0, hi = s->len;
+	while (lo < hi) {
+		const uint32_t mid = lo + (hi - lo) / 2;
+		if (e[mid].key < limit)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	/* keys grow with the distance from n, so the first overlapping
+	 * leaf is the closest one */
+	for (uint32_t i = lo; i < s->len; i++) {
+		if (e[i].node != n && e[i].lo < self.hi && e[i].hi > self.lo)
+			return e[i].node;
+	}
+	return NULL;
+}
+
+void
+spatial_free(spatial_t *s)
+{
+	for (int i = 0; i < SPATIAL_AXES; i++) {
+		free(s->edges[i]);
+	}
+	*s = (spatial_t){0};
+}
@@ -41,125 +41,300 @@
 #include <xcb/xcb_icccm.h>
 
 #include "helper.h"
+#include "layout.h"
+#include "pool.h"
+#include "registry.h"
+#include "spatial.h"
 #include "type.h"
 #include "zwm.h"
 
 // clang-format off
-static void master_layout(node_t *parent, node_t *);
-static void stack_layout(node_t *parent);
-static void default_layout(node_t *parent);
-static node_t *find_tree_root(node_t *);
+static void master_layout(desktop_t *d, node_t *n);
+static rectangle_t desktop_area(desktop_t *d);
 static bool is_parent_null(const node_t *node);
-static void horizontal_resize(node_t *n, resize_t t);
+static void index_leaf(node_t *n, desktop_t *d);
+static node_t *move_node(node_t *node, desktop_t *from, desktop_t *to);
+static void leaf_insert_after(desktop_t *d, node_t *prev, node_t *n);
+static void leaf_remove(desktop_t *d, node_t *n);
+static void leaf_replace(desktop_t *d, node_t *old, node_t *n);
+static void thread_split(desktop_t *d, node_t *p);
+static void move_roles(desktop_t *d, node_t *from, node_t *to);
+static void thread_subtree(desktop_t *d, node_t *n, node_t *before, node_t *after);
+static void reset_split(node_t *n);
+static void take_split(node_t *to, const node_t *from, bool swapped);
 // clang-format on
 
+/* nodes and clients come from the pools of the desktop they live on.
+ * the client stays with the caller when no node can be allocated */
 node_t *
-create_node(client_t *c)
+create_node(client_t *c, desktop_t *d)
 {
 	if (c == 0x00)
 		return NULL;
 
-	node_t *node = (node_t *)malloc(sizeof(node_t));
-	if (node == 0x00) {
-		free(c);
+	node_t *node = (node_t *)pool_alloc(&d->node_pool);
+	if (node == 0x00)
 		return NULL;
-	}
 
-	node->client	   = c;
-	node->parent	   = NULL;
-	node->first_child  = NULL;
-	node->second_child = NULL;
-	node->is_master	   = false;
-	node->is_focused   = false;
+	node->client		 = c;
+	node->parent		 = NULL;
+	node->first_child	 = NULL;
+	node->second_child	 = NULL;
+	node->prev_leaf		 = NULL;
+	node->next_leaf		 = NULL;
+	node->is_master		 = false;
+	node->is_focused	 = false;
+	node->is_dirty		 = false;
+	node->is_dirty_below = false;
+	reset_split(node);
 
 	return node;
 }
 
 node_t *
-init_root(void)
+init_root(desktop_t *d)
 {
-	node_t *node = (node_t *)malloc(sizeof(node_t));
+	node_t *node = (node_t *)pool_alloc(&d->node_pool);
 	if (node == 0x00)
 		return NULL;
 
-	node->client	   = NULL;
-	node->parent	   = NULL;
-	node->first_child  = NULL;
-	node->second_child = NULL;
-	node->node_type	   = ROOT_NODE;
-	node->is_master	   = false;
-	node->is_focused   = false;
+	node->client		 = NULL;
+	node->parent		 = NULL;
+	node->first_child	 = NULL;
+	node->second_child	 = NULL;
+	node->prev_leaf		 = NULL;
+	node->next_leaf		 = NULL;
+	node->node_type		 = ROOT_NODE;
+	node->is_master		 = false;
+	node->is_focused	 = false;
+	node->is_dirty		 = false;
+	node->is_dirty_below = false;
+	reset_split(node);
 
 	return node;
 }
 
-int
-render_tree(node_t *node)
+/* a leaf that is split starts out halved along its longer side */
+static void
+reset_split(node_t *n)
 {
-	if (node == NULL)
-		return 0;
+	n->split_type  = DYNAMIC_TYPE;
+	n->split_ratio = SPLIT_RATIO;
+}
 
-	node_t **stack = malloc(10 * sizeof(node_t *));
-	if (stack == NULL) {
-		_LOG_(ERROR, "Stack allocation failed\n");
-		return -1;
+/* to takes over the children of from, swapped when they trade places */
+static void
+take_split(node_t *to, const node_t *from, bool swapped)
+{
+	to->split_type	= from->split_type;
+	to->split_ratio = swapped ? 1 - from->split_ratio : from->split_ratio;
+}
+
+/* the tree changed: a layout cached for the old one no longer holds and
+ * the spatial index may point at leaves that are gone or have moved */
+static void
+bump_generation(desktop_t *d)
+{
+	d->generation++;
+	d->spatial.is_valid = false;
+}
+
+/* the leaves of a desktop are threaded into a doubly linked list in
+ * in-order sequence, so walking its windows needs neither recursion
+ * nor an allocation. every change to the shape of the tree keeps
+ * d->first_leaf and d->last_leaf in step through the helpers below,
+ * which also bump d->generation */
+static void
+leaf_insert_after(desktop_t *d, node_t *prev, node_t *n)
+{
+	bump_generation(d);
+	n->prev_leaf = prev;
+	n->next_leaf = (prev != NULL) ? prev->next_leaf : d->first_leaf;
+
+	if (n->next_leaf != NULL)
+		n->next_leaf->prev_leaf = n;
+	else
+		d->last_leaf = n;
+
+	if (prev != NULL)
+		prev->next_leaf = n;
+	else
+		d->first_leaf = n;
+}
+
+static void
+leaf_remove(desktop_t *d, node_t *n)
+{
+	bump_generation(d);
+	if (n->prev_leaf != NULL)
+		n->prev_leaf->next_leaf = n->next_leaf;
+	else
+		d->first_leaf = n->next_leaf;
+
+	if (n->next_leaf != NULL)
+		n->next_leaf->prev_leaf = n->prev_leaf;
+	else
+		d->last_leaf = n->prev_leaf;
+
+	n->prev_leaf = NULL;
+	n->next_leaf = NULL;
+}
+
+static void
+leaf_replace(desktop_t *d, node_t *old, node_t *n)
+{
+	node_t *prev = old->prev_leaf;
+	leaf_remove(d, old);
+	leaf_insert_after(d, prev, n);
+}
+
+/* p was a leaf and has just been split into its two children */
+static void
+thread_split(desktop_t *d, node_t *p)
+{
+	leaf_replace(d, p, p->first_child);
+	leaf_insert_after(d, p->first_child, p->second_child);
+}
+
+/* the client of from now lives in to, so focus and the master role
+ * follow it there */
+static void
+move_roles(desktop_t *d, node_t *from, node_t *to)
+{
+	to->is_focused	 = from->is_focused;
+	from->is_focused = false;
+	if (d->focused_node == from) {
+		d->focused_node = to;
 	}
+	if (d->master_node == from) {
+		update_master(d, to);
+	}
+}
 
-	int stack_size = 10;
-	int top		   = -1;
-	stack[++top]   = node;
+static void
+thread_leaves(desktop_t *d, node_t *n, node_t **prev)
+{
+	if (n == NULL)
+		return;
 
-	while (top >= 0) {
-		node_t *current_node = stack[top--];
+	if (n->first_child == NULL && n->second_child == NULL) {
+		if (n->client == NULL)
+			return;
+		n->prev_leaf = *prev;
+		if (*prev != NULL)
+			(*prev)->next_leaf = n;
+		else
+			d->first_leaf = n;
+		*prev = n;
+		return;
+	}
 
-		if (current_node == NULL)
-			continue;
+	thread_leaves(d, n->first_child, prev);
+	thread_leaves(d, n->second_child, prev);
+}
 
-		if (!IS_INTERNAL(current_node) && current_node->client != NULL) {
-			bool flag = IS_FULLSCREEN(current_node->client);
-			if (!flag) {
-				if (tile(current_node) != 0) {
-					_LOG_(ERROR,
-						  "error tiling window %d",
-						  current_node->client->window);
-					free(stack);
-					return -1;
-				}
-			}
-		}
+/* re-threads the leaves under n, which sit between before and after */
+static void
+thread_subtree(desktop_t *d, node_t *n, node_t *before, node_t *after)
+{
+	node_t *last = before;
+	bump_generation(d);
+	thread_leaves(d, n, &last);
 
-		if (current_node->second_child != NULL) {
-			if (top == stack_size - 1) {
-				stack_size *= 2;
-				node_t **new_stack =
-					realloc(stack, stack_size * sizeof(node_t *));
-				if (new_stack == NULL) {
-					_LOG_(ERROR, "Stack reallocation failed\n");
-					free(stack);
-					return -1;
-				}
-				stack = new_stack;
-			}
-			stack[++top] = current_node->second_child;
-		}
+	if (last != NULL)
+		last->next_leaf = after;
+	else
+		d->first_leaf = after;
 
-		if (current_node->first_child != NULL) {
-			if (top == stack_size - 1) {
-				stack_size *= 2;
-				node_t **new_stack =
-					realloc(stack, stack_size * sizeof(node_t *));
-				if (new_stack == NULL) {
-					_LOG_(ERROR, "Stack reallocation failed\n");
-					free(stack);
-					return -1;
-				}
-				stack = new_stack;
-			}
-			stack[++top] = current_node->first_child;
-		}
+	if (after != NULL)
+		after->prev_leaf = last;
+	else
+		d->last_leaf = last;
+}
+
+void
+relink_leaves(desktop_t *d)
+{
+	d->first_leaf = NULL;
+	d->last_leaf  = NULL;
+	thread_subtree(d, d->tree, NULL, NULL);
+}
+
+/* a change to the tree marks the node it touched and every ancestor,
+ * so the next layout pass finds it without looking at the rest */
+void
+mark_dirty(desktop_t *d, node_t *n)
+{
+	if (n == NULL)
+		return;
+
+	n->is_dirty = true;
+	for (node_t *p = n->parent; p != NULL; p = p->parent) {
+		p->is_dirty_below = true;
 	}
+	bump_generation(d);
+}
+
+static void
+tile_changed(node_t *n, void *arg)
+{
+	int *err = (int *)arg;
+	if (IS_FULLSCREEN(n->client))
+		return;
+
+	if (tile(n) != 0) {
+		_LOG_(ERROR, "error tiling window %d", n->client->window);
+		*err = -1;
+	}
+}
 
-	free(stack);
+/* lays out and tiles only the subtrees marked since the last pass. the
+ * other layouts do not follow the tree's shape, so any change there
+ * places every leaf again in one pass over the leaf sequence */
+int
+render_changes(desktop_t *d)
+{
+	if (d->tree == NULL ||
+		!(d->tree->is_dirty || d->tree->is_dirty_below))
+		return 0;
+
+	const layout_params_t lp  = get_layout_params();
+	int					  err = 0;
+	d->spatial.is_valid		  = false;
+	if (d->layout == DEFAULT) {
+		layout_dirty(d->tree, &lp, tile_changed, &err);
+		return err;
+	}
+
+	layout_clear_dirty(d->tree);
+	layout_flat(d->layout,
+				d->first_leaf,
+				d->master_node,
+				desktop_area(d),
+				&lp,
+				tile_changed,
+				&err);
+	return err;
+}
+
+/* lays out what changed and hands every window to tile(), which only
+ * sends those whose geometry differs from what the server has; drawing
+ * a desktop that has not changed since it was hidden costs no layout
+ * work and leaves its spatial index as it was */
+int
+render_tree(desktop_t *d)
+{
+	if (render_changes(d) != 0)
+		return -1;
+
+	for (node_t *n = d->first_leaf; n != NULL; n = n->next_leaf) {
+		if (IS_FULLSCREEN(n->client))
+			continue;
+		if (tile(n) != 0) {
+			_LOG_(ERROR, "error tiling window %d", n->client->window);
+			return -1;
+		}
+	}
 	return 0;
 }
 
@@ -220,54 +395,20 @@ insert_floating_node(node_t *node, desktop_t *d)
 	node->node_type = EXTERNAL_NODE;
 }
 
+/* a client only ever lands in a new node through insert_node,
+ * unlink_node and transfer_node, which report it here so the window
+ * registry can point straight at it */
 static void
-split_node(node_t *n, node_t *nd)
+index_leaf(node_t *n, desktop_t *d)
 {
-	if (IS_FLOATING(nd->client)) {
-		n->first_child->rectangle = n->rectangle;
-	} else {
-		if (n->rectangle.width >= n->rectangle.height) {
-			n->first_child->rectangle.x = n->rectangle.x;
-			n->first_child->rectangle.y = n->rectangle.y;
-			n->first_child->rectangle.width =
-				(n->rectangle.width -
-				 (conf.window_gap - conf.border_width)) /
-				2;
-			n->first_child->rectangle.height = n->rectangle.height;
-
-			n->second_child->rectangle.x =
-				(int16_t)(n->rectangle.x +
-						  n->first_child->rectangle.width +
-						  conf.window_gap + conf.border_width);
-			n->second_child->rectangle.y = n->rectangle.y;
-			n->second_child->rectangle.width =
-				n->rectangle.width - n->first_child->rectangle.width -
-				conf.window_gap - conf.border_width;
-			n->second_child->rectangle.height = n->rectangle.height;
-		} else {
-			n->first_child->rectangle.x		= n->rectangle.x;
-			n->first_child->rectangle.y		= n->rectangle.y;
-			n->first_child->rectangle.width = n->rectangle.width;
-			n->first_child->rectangle.height =
-				(n->rectangle.height -
-				 (conf.window_gap - conf.border_width)) /
-				2;
-
-			n->second_child->rectangle.x = n->rectangle.x;
-			n->second_child->rectangle.y =
-				(int16_t)(n->rectangle.y +
-						  n->first_child->rectangle.height +
-						  conf.window_gap + conf.border_width);
-			n->second_child->rectangle.width = n->rectangle.width;
-			n->second_child->rectangle.height =
-				n->rectangle.height - n->first_child->rectangle.height -
-				conf.window_gap - conf.border_width;
-		}
-	}
+	if (n == NULL || n->client == NULL)
+		return;
+
+	registry_attach(n->client->window, get_monitor_from_desktop(d), d, n);
 }
 
 void
-insert_node(node_t *node, node_t *new_node, layout_t layout)
+insert_node(node_t *node, node_t *new_node, desktop_t *d)
 {
 #ifdef _DEBUG__
 	char *n	 = win_name(node->client->window);
@@ -295,14 +436,12 @@ insert_node(node_t *node, node_t *new_node, layout_t layout)
 	if (!IS_ROOT(node))
 		node->node_type = INTERNAL_NODE;
 
-	node->first_child = create_node(node->client);
+	reset_split(node);
+	node->first_child = create_node(node->client, d);
 	if (node->first_child == NULL)
 		return;
 
-	if (node->is_master) {
-		node->is_master				 = false;
-		node->first_child->is_master = true;
-	}
+	move_roles(d, node, node->first_child);
 
 	node->first_child->parent	 = node;
 	node->first_child->node_type = EXTERNAL_NODE;
@@ -314,44 +453,66 @@ insert_node(node_t *node, node_t *new_node, layout_t layout)
 
 	node->second_child->parent	  = node;
 	node->second_child->node_type = EXTERNAL_NODE;
+	thread_split(d, node);
+	index_leaf(node->first_child, d);
+	index_leaf(new_node, d);
 
-	if (layout == DEFAULT) {
-		split_node(node, new_node);
-	} else if (layout == STACK) {
-		node->second_child->rectangle = node->first_child->rectangle =
-			node->rectangle;
-
-	} else if (layout == MASTER) {
-		// todo
-		node_t *p = find_tree_root(node);
-		node_t *m = find_master_node(p);
-		master_layout(p, m);
+	/* only the split node is laid out again in the default layout, the
+	 * others place every window from the leaf sequence anyway */
+	if (d->layout == MASTER && d->master_node == NULL) {
+		master_layout(d, NULL);
 	}
+	mark_dirty(d, node);
 }
 
-static void
-arrange_tree(node_t *tree, layout_t l)
+/* the part of its monitor a desktop's windows may cover */
+static rectangle_t
+desktop_area(desktop_t *d)
 {
-	switch (l) {
-	case DEFAULT: {
-		default_layout(tree);
-		break;
-	}
-	case MASTER: {
-		node_t *m = find_master_node(tree);
-		master_layout(tree, m);
-		break;
-	}
-	case STACK: {
-		stack_layout(tree);
-		break;
-	}
-	case GRID: break;
+	return get_work_area(get_monitor_from_desktop(d));
+}
+
+static bool
+same_layout_key(const layout_key_t *a, const layout_key_t *b)
+{
+	return a->is_valid && b->is_valid && a->generation == b->generation &&
+		   a->layout == b->layout && a->area.x == b->area.x &&
+		   a->area.y == b->area.y && a->area.width == b->area.width &&
+		   a->area.height == b->area.height &&
+		   a->params.window_gap == b->params.window_gap &&
+		   a->params.border_width == b->params.border_width &&
+		   a->params.master_ratio == b->params.master_ratio;
+}
+
+/* the whole tree is laid out again by the next render, unless nothing
+ * it was last laid out from has changed since */
+void
+arrange_tree(desktop_t *d)
+{
+	if (d->tree == NULL)
+		return;
+
+	const layout_key_t key = {.area		  = desktop_area(d),
+							  .params	  = get_layout_params(),
+							  .generation = d->generation,
+							  .layout	  = d->layout,
+							  .is_valid	  = true};
+	if (same_layout_key(&d->laid_out, &key))
+		return;
+
+	if (d->layout == MASTER) {
+		master_layout(d, d->master_node);
 	}
+	d->tree->rectangle = layout_root_rect(key.area, &key.params);
+	mark_dirty(d, d->tree);
+	/* the layout just marked is what the key now stands for */
+	d->laid_out			   = key;
+	d->laid_out.generation = d->generation;
 }
 
-node_t *
-find_node_by_window_id(node_t *root, xcb_window_t win)
+#ifdef _DEBUG__
+static node_t *
+find_node_in_tree(node_t *root, xcb_window_t win)
 {
 	if (root == NULL)
 		return NULL;
@@ -360,108 +521,78 @@ find_node_by_window_id(node_t *root, xcb_window_t win)
 		return root;
 	}
 
-	node_t *l = find_node_by_window_id(root->first_child, win);
+	node_t *l = find_node_in_tree(root->first_child, win);
 	if (l != NULL)
 		return l;
 
-	node_t *r = find_node_by_window_id(root->second_child, win);
-	if (r != NULL)
-		return r;
-
-	return NULL;
+	return find_node_in_tree(root->second_child, win);
 }
+#endif
 
-void
-free_tree(node_t *root)
+/* root is a desktop tree; windows managed on any other desktop are not
+ * reported even though the registry knows where they are */
+node_t *
+find_node_by_window_id(node_t *root, xcb_window_t win)
 {
 	if (root == NULL)
-		return;
+		return NULL;
 
-	if (root->client != NULL) {
-		free(root->client);
-		root->client = NULL;
+	desktop_t *d = NULL;
+	node_t	  *n = registry_lookup(win, NULL, &d);
+	if (n != NULL && d->tree != root)
+		n = NULL;
+#ifdef _DEBUG__
+	/* debug builds still walk the tree, to catch the registry missing
+	 * a node move */
+	if (find_node_in_tree(root, win) != n) {
+		_LOG_(WARNING, "registry is out of step for window %d", win);
 	}
-
-	node_t *f = root->first_child;
-	free_tree(f);
-	root->first_child = NULL;
-	node_t *s		  = root->second_child;
-	free_tree(s);
-	root->second_child = NULL;
-	free(root);
+#endif
+	return n;
 }
 
-void
-resize_subtree(node_t *parent)
+static void
+forget_windows(node_t *root)
 {
-	if (parent == NULL)
+	if (root == NULL)
 		return;
 
-	rectangle_t r, r2 = {0};
-
-	if (parent->rectangle.width >= parent->rectangle.height) {
-		r.x		= parent->rectangle.x;
-		r.y		= parent->rectangle.y;
-		r.width = (parent->rectangle.width -
-				   (conf.window_gap - conf.border_width)) /
-				  2;
-		r.height = parent->rectangle.height;
-
-		r2.x = (int16_t)(parent->rectangle.x + r.width + conf.window_gap +
-						 conf.border_width);
-		r2.y = parent->rectangle.y;
-		r2.width = parent->rectangle.width - r.width - conf.window_gap -
-				   conf.border_width;
-		r2.height = parent->rectangle.height;
-	} else {
-		r.x		 = parent->rectangle.x;
-		r.y		 = parent->rectangle.y;
-		r.width	 = parent->rectangle.width;
-		r.height = (parent->rectangle.height -
-					(conf.window_gap - conf.border_width)) /
-				   2;
-
-		r2.x = parent->rectangle.x;
-		r2.y = (int16_t)(parent->rectangle.y + r.height + conf.window_gap +
-						 conf.border_width);
-		r2.width  = parent->rectangle.width;
-		r2.height = parent->rectangle.height - r.height - conf.window_gap -
-					conf.border_width;
-	}
-
-	if (parent->first_child != NULL) {
-		parent->first_child->rectangle = r;
-		if (IS_INTERNAL(parent->first_child)) {
-			resize_subtree(parent->first_child);
-		}
+	if (root->client != NULL) {
+		registry_detach(root->client->window);
 	}
 
-	if (parent->second_child != NULL) {
-		parent->second_child->rectangle = r2;
-		if (IS_INTERNAL(parent->second_child)) {
-			resize_subtree(parent->second_child);
-		}
-	}
+	forget_windows(root->first_child);
+	forget_windows(root->second_child);
 }
 
-node_t *
-find_master_node(node_t *root)
+/* every node and client of a desktop lives in its two pools, so the
+ * whole tree goes back to the heap slab by slab */
+void
+free_tree(desktop_t *d)
 {
-	if (root == NULL)
-		return NULL;
-
-	if (root->is_master)
-		return root;
-
-	node_t *l = find_master_node(root->first_child);
-	if (l != NULL)
-		return l;
-
-	node_t *r = find_master_node(root->second_child);
-	if (r != NULL)
-		return r;
+	forget_windows(d->tree);
+	d->tree			= NULL;
+	d->focused_node = NULL;
+	d->master_node	= NULL;
+	d->first_leaf	= NULL;
+	d->last_leaf	= NULL;
+	pool_destroy(&d->node_pool);
+	pool_destroy(&d->client_pool);
+	spatial_free(&d->spatial);
+}
 
-	return NULL;
+/* the desktop keeps its master node next to the is_master flag, so
+ * the master layout never has to search the tree for it */
+void
+update_master(desktop_t *d, node_t *n)
+{
+	if (d->master_node != NULL) {
+		d->master_node->is_master = false;
+	}
+	if (n != NULL) {
+		n->is_master = true;
+	}
+	d->master_node = n;
 }
 
 static node_t *
@@ -501,25 +632,20 @@ is_sibling_floating(node_t *node)
 }
 
 static void
-populate_win_array(node_t *root, xcb_window_t *arr, size_t *index)
+populate_win_array(const desktop_t *d, xcb_window_t *arr, size_t *index)
 {
-	if (root == NULL)
-		return;
-
-	if (root->client != NULL && root->client->window != XCB_NONE) {
-		arr[*index] = root->client->window;
-		(*index)++;
+	for (node_t *n = d->first_leaf; n != NULL; n = n->next_leaf) {
+		if (n->client->window != XCB_NONE) {
+			arr[*index] = n->client->window;
+			(*index)++;
+		}
 	}
-
-	populate_win_array(root->first_child, arr, index);
-	populate_win_array(root->second_child, arr, index);
 }
 
 void
 restack(void)
 {
-	size_t size =
-		cur_monitor->desktops[get_focused_desktop_idx()]->n_count + 5;
+	size_t size = cur_monitor->focused_desktop->n_count + 5;
 	if (size == 0) {
 		return;
 	}
@@ -530,10 +656,10 @@ restack(void)
 	if (clients == NULL) {
 		return;
 	}
-	size_t	index = 0;
+	size_t	   index = 0;
 
-	node_t *root  = cur_monitor->desktops[get_focused_desktop_idx()]->tree;
-	populate_win_array(root, clients, &index);
+	desktop_t *d	 = cur_monitor->focused_desktop;
+	populate_win_array(d, clients, &index);
 
 	for (size_t i = 1; i <= index; i++) {
 		window_above(clients[i], clients[i - 1]);
@@ -701,15 +827,6 @@ has_external_children(const node_t *parent)
 			IS_EXTERNAL(parent->second_child));
 }
 
-static node_t *
-find_tree_root(node_t *node)
-{
-	if (IS_ROOT(node)) {
-		return node;
-	}
-	return find_tree_root(node->parent);
-}
-
 static bool
 has_single_external_child(const node_t *parent)
 {
@@ -726,288 +843,30 @@ has_single_external_child(const node_t *parent)
 			 !IS_EXTERNAL(parent->first_child)));
 }
 
-static client_t *
-find_client_by_window_id(node_t *root, xcb_window_t win)
-{
-	if (root == NULL)
-		return NULL;
-
-	if (root->client != NULL && root->client->window == win) {
-		return root->client;
-	}
-
-	node_t *l = find_node_by_window_id(root->first_child, win);
-	if (l == NULL)
-		return NULL;
-
-	if (l->client != NULL) {
-		return l->client;
-	}
-
-	node_t *r = find_node_by_window_id(root->second_child, win);
-	if (r == NULL)
-		return NULL;
-
-	if (r->client != NULL) {
-		return r->client;
-	}
-
-	return NULL;
-}
-
-void
-apply_default_layout(node_t *root)
-{
-	if (root == NULL)
-		return;
-
-	if (root->first_child == NULL && root->second_child == NULL) {
-		return;
-	}
-
-	rectangle_t r, r2 = {0};
-
-	if (root->rectangle.width >= root->rectangle.height) {
-		r.x		= root->rectangle.x;
-		r.y		= root->rectangle.y;
-		r.width = (root->rectangle.width -
-				   (conf.window_gap - conf.border_width)) /
-				  2;
-		r.height = root->rectangle.height;
-
-		r2.x = (int16_t)(root->rectangle.x + r.width + conf.window_gap +
-						 conf.border_width);
-		r2.y = root->rectangle.y;
-		r2.width = root->rectangle.width - r.width - conf.window_gap -
-				   conf.border_width;
-		r2.height = root->rectangle.height;
-	} else {
-		r.x		 = root->rectangle.x;
-		r.y		 = root->rectangle.y;
-		r.width	 = root->rectangle.width;
-		r.height = (root->rectangle.height -
-					(conf.window_gap - conf.border_width)) /
-				   2;
-
-		r2.x = root->rectangle.x;
-		r2.y = (int16_t)(root->rectangle.y + r.height + conf.window_gap +
-						 conf.border_width);
-		r2.width  = root->rectangle.width;
-		r2.height = root->rectangle.height - r.height - conf.window_gap -
-					conf.border_width;
-	}
-
-	if (root->first_child != NULL) {
-		root->first_child->rectangle =
-			((root->second_child->client != NULL) &&
-			 IS_FLOATING(root->second_child->client))
-				? root->rectangle
-			: ((root->first_child->client != NULL) &&
-			   IS_FLOATING(root->first_child->client))
-				? root->first_child->floating_rectangle
-				: r;
-		if (IS_INTERNAL(root->first_child)) {
-			apply_default_layout(root->first_child);
-		}
-	}
-
-	if (root->second_child != NULL) {
-		root->second_child->rectangle =
-			((root->first_child->client != NULL) &&
-			 IS_FLOATING(root->first_child->client))
-				? root->rectangle
-			: ((root->second_child->client != NULL) &&
-			   IS_FLOATING(root->second_child->client))
-				? root->second_child->floating_rectangle
-				: r2;
-		if (IS_INTERNAL(root->second_child)) {
-			apply_default_layout(root->second_child);
-		}
-	}
-}
-
+/* the master defaults to the leftmost leaf when none is set */
 static void
-default_layout(node_t *root)
-{
-	if (root == NULL)
-		return;
-
-	rectangle_t	   r = {0};
-	// const uint16_t w = wm->screen->width_in_pixels;
-	// const uint16_t h = wm->screen->height_in_pixels;
-	uint16_t	   w = cur_monitor->rectangle.width;
-	uint16_t	   h = cur_monitor->rectangle.height;
-	const uint16_t x = cur_monitor->rectangle.x;
-	const uint16_t y = cur_monitor->rectangle.y;
-	if (wm->bar != NULL && cur_monitor == prim_monitor) {
-		r.x		 = x + conf.window_gap;
-		r.y		 = y + wm->bar->rectangle.height + conf.window_gap;
-		r.width	 = w - 2 * conf.window_gap - 2 * conf.border_width;
-		r.height = h - wm->bar->rectangle.height - 2 * conf.window_gap -
-				   2 * conf.border_width;
-	} else {
-		r.x		 = x + conf.window_gap;
-		r.y		 = y + conf.window_gap;
-		r.width	 = w - 2 * conf.window_gap - 2 * conf.border_width;
-		r.height = h - 2 * conf.window_gap - 2 * conf.border_width;
-	}
-	root->rectangle = r;
-	apply_default_layout(root);
-}
-
-// TODO: use next_node() to implement this
-void
-apply_master_layout(node_t *parent)
+master_layout(desktop_t *d, node_t *n)
 {
-	if (parent == NULL)
-		return;
-
-	if (parent->first_child->is_master) {
-		parent->second_child->rectangle = parent->rectangle;
-	} else if (parent->second_child->is_master) {
-		parent->first_child->rectangle = parent->rectangle;
-	} else {
-		rectangle_t r, r2 = {0};
-		r.x		 = parent->rectangle.x;
-		r.y		 = parent->rectangle.y;
-		r.width	 = parent->rectangle.width;
-		r.height = (parent->rectangle.height -
-					(conf.window_gap - conf.border_width)) /
-				   2;
-
-		r2.x = parent->rectangle.x;
-		r2.y = (int16_t)(parent->rectangle.y + r.height + conf.window_gap +
-						 conf.border_width);
-		r2.width  = parent->rectangle.width;
-		r2.height = parent->rectangle.height - r.height - conf.window_gap -
-					conf.border_width;
-		parent->first_child->rectangle	= r;
-		parent->second_child->rectangle = r2;
-	}
-
-	if (IS_INTERNAL(parent->first_child)) {
-		apply_master_layout(parent->first_child);
-	}
-
-	if (IS_INTERNAL(parent->second_child)) {
-		apply_master_layout(parent->second_child);
-	}
-}
-
-static void
-master_layout(node_t *root, node_t *n)
-{
-	const double   ratio		= 0.70;
-	// uint64_t	 w			  = wm->screen->width_in_pixels;
-	// uint64_t	 h			  = wm->screen->height_in_pixels;
-	uint16_t	   w			= cur_monitor->rectangle.width;
-	uint16_t	   h			= cur_monitor->rectangle.height;
-	const uint16_t x			= cur_monitor->rectangle.x;
-	const uint16_t y			= cur_monitor->rectangle.y;
-	uint16_t	   master_width = w * ratio;
-	uint16_t	   r_width		= (uint16_t)(w * (1 - ratio));
 	if (n == NULL) {
-		n = find_left_leaf(root);
+		n = find_left_leaf(d->tree);
 		if (n == NULL) {
 			return;
 		}
 	}
-	n->is_master		= true;
-	uint16_t bar_height = wm->bar == NULL ? 0 : wm->bar->rectangle.height;
-	rectangle_t r1		= {
-			 .x		 = x + conf.window_gap,
-			 .y		 = (int16_t)(y + bar_height + conf.window_gap),
-			 .width	 = (uint16_t)(master_width - 2 * conf.window_gap),
-			 .height = (uint16_t)(h - 2 * conf.window_gap - bar_height),
-	 };
-
-	rectangle_t r2 = {
-		.x		= (x + master_width),
-		.y		= (int16_t)(y + bar_height + conf.window_gap),
-		.width	= (uint16_t)(r_width - (1 * conf.window_gap)),
-		.height = (uint16_t)(h - 2 * conf.window_gap - bar_height),
-	};
-
-	n->rectangle	= r1;
-	root->rectangle = r2;
-	apply_master_layout(root);
-}
-
-static void
-master_clean_up(node_t *root)
-{
-	if (root == NULL)
-		return;
-
-	if (root->is_master)
-		root->is_master = false;
-	master_clean_up(root->first_child);
-	master_clean_up(root->second_child);
+	update_master(d, n);
+	mark_dirty(d, d->tree);
 }
 
-void
-apply_stack_layout(node_t *root)
-{
-	if (root == NULL)
-		return;
-
-	if (root->first_child == NULL && root->second_child == NULL) {
-		return;
-	}
-
-	if (root->first_child != NULL) {
-		root->first_child->rectangle = root->rectangle;
-		if (IS_INTERNAL(root->first_child)) {
-			apply_stack_layout(root->first_child);
-		}
-	}
-
-	if (root->second_child != NULL) {
-		root->second_child->rectangle = root->rectangle;
-		if (IS_INTERNAL(root->second_child)) {
-			apply_stack_layout(root->second_child);
-		}
-	}
-}
-
-static void
-stack_layout(node_t *root)
-{
-	rectangle_t	   r = {0};
-	// const uint16_t w = wm->screen->width_in_pixels;
-	// const uint16_t h = wm->screen->height_in_pixels;
-	uint16_t	   w = cur_monitor->rectangle.width;
-	uint16_t	   h = cur_monitor->rectangle.height;
-	const uint16_t x = cur_monitor->rectangle.x;
-	const uint16_t y = cur_monitor->rectangle.y;
-	if (wm->bar != NULL && cur_monitor == prim_monitor) {
-		r.x		 = x + conf.window_gap;
-		r.y		 = y + wm->bar->rectangle.height + conf.window_gap;
-		r.width	 = w - 2 * conf.window_gap - 2 * conf.border_width;
-		r.height = h - wm->bar->rectangle.height - 2 * conf.window_gap -
-				   2 * conf.border_width;
-	} else {
-		r.x		 = x + conf.window_gap;
-		r.y		 = y + conf.window_gap;
-		r.width	 = w - 2 * conf.window_gap - 2 * conf.border_width;
-		r.height = h - 2 * conf.window_gap - 2 * conf.border_width;
-	}
-	root->rectangle = r;
-	apply_stack_layout(root);
-}
-
-// void grid_layout(node_t *root) {
-// }
-
 void
 apply_layout(desktop_t *d, layout_t t)
 {
-	d->layout	 = t;
 	node_t *root = d->tree;
-	master_clean_up(root);
+
+	d->layout = t;
+	update_master(d, NULL);
 	switch (t) {
 	case DEFAULT: {
-		default_layout(root);
+		arrange_tree(d);
 		break;
 	}
 	case MASTER: {
@@ -1020,7 +879,7 @@ apply_layout(desktop_t *d, layout_t t)
 		if (n == NULL) {
 			return;
 		}
-		master_layout(root, n);
+		master_layout(d, n);
 		break;
 	}
 	case STACK: {
@@ -1033,19 +892,21 @@ apply_layout(desktop_t *d, layout_t t)
 		if (n == NULL) {
 			return;
 		}
-		stack_layout(root);
+		arrange_tree(d);
 		set_focus(n, true);
+		update_focus(d, n);
 		d->top_w = n->client->window;
 		break;
 	}
 	case GRID: {
+		arrange_tree(d);
 		break;
 	}
 	}
 }
 
 static int
-delete_node_with_external_sibling(node_t *node)
+delete_node_with_external_sibling(node_t *node, desktop_t *d)
 {
 	/* node to delete = N, internal node = I, external node = E
 	 *         I
@@ -1093,11 +954,11 @@ delete_node_with_external_sibling(node_t *node)
 			grandparent->second_child->second_child = NULL;
 		}
 	}
-	free(external_node);
+	pool_release(&d->node_pool, external_node);
 	external_node = NULL;
-	free(node->client);
+	pool_release(&d->client_pool, node->client);
 	node->client = NULL;
-	free(node);
+	pool_release(&d->node_pool, node);
 	node = NULL;
 	return 0;
 }
@@ -1108,6 +969,7 @@ delete_node_with_internal_sibling(node_t *node, desktop_t *d)
 	if (d == NULL) {
 		return -1;
 	}
+	const layout_params_t lp = get_layout_params();
 	/* node to delete = N
 	 * internal node (parent of N) = IN
 	 * external node 1 = E1, external node 2 = E2
@@ -1151,11 +1013,7 @@ delete_node_with_internal_sibling(node_t *node, desktop_t *d)
 			}
 		}
 
-		if (d->layout == DEFAULT) {
-			apply_default_layout(d->tree);
-		} else if (d->layout == STACK) {
-			apply_stack_layout(d->tree);
-		}
+		mark_dirty(d, d->tree);
 
 	} else {
 		// if IN has a parent
@@ -1189,19 +1047,15 @@ delete_node_with_internal_sibling(node_t *node, desktop_t *d)
 			node->parent->first_child = internal_sibling->second_child;
 			internal_sibling->second_child->parent = node->parent;
 		}
-		resize_subtree(node->parent);
-		if (d->layout == DEFAULT) {
-			apply_default_layout(node->parent);
-		} else if (d->layout == STACK) {
-			apply_stack_layout(node->parent);
-		}
+		layout_resize_subtree(node->parent, &lp);
+		mark_dirty(d, node->parent);
 	}
 
-	free(internal_sibling);
+	pool_release(&d->node_pool, internal_sibling);
 	internal_sibling = NULL;
-	free(node->client);
+	pool_release(&d->client_pool, node->client);
 	node->client = NULL;
-	free(node);
+	pool_release(&d->node_pool, node);
 	node = NULL;
 	return 0;
 }
@@ -1225,9 +1079,9 @@ delete_floating_node(node_t *node, desktop_t *d)
 		p->second_child = NULL;
 	}
 	node->parent = NULL;
-	free(node->client);
+	pool_release(&d->client_pool, node->client);
 	node->client = NULL;
-	free(node);
+	pool_release(&d->node_pool, node);
 	node = NULL;
 	assert(p->first_child == NULL);
 	assert(p->second_child == NULL);
@@ -1259,11 +1113,22 @@ delete_node(node_t *node, desktop_t *d)
 		return;
 	}
 
+	if (d->focused_node == node) {
+		d->focused_node = NULL;
+	}
+
+	if (d->master_node == node) {
+		update_master(d, NULL);
+	}
+
+	registry_detach(node->client->window);
+
 	// early check if only single node/client is mapped to the screen
 	if (node == d->tree) {
-		free(node->client);
+		leaf_remove(d, node);
+		pool_release(&d->client_pool, node->client);
 		node->client = NULL;
-		free(node);
+		pool_release(&d->node_pool, node);
 		node	= NULL;
 		d->tree = NULL;
 		goto out;
@@ -1277,7 +1142,7 @@ delete_node(node_t *node, desktop_t *d)
 	 */
 	// if (is_sibling_external(node)) {
 	// 	xcb_window_t w = node->client->window;
-	// 	if (delete_node_with_external_sibling(node) != 0) {
+	// 	if (delete_node_with_external_sibling(node, d) != 0) {
 	// 		_LOG_(ERROR, "cannot delete node with id: %d", w);
 	// 		return;
 	// 	}
@@ -1303,15 +1168,15 @@ delete_node(node_t *node, desktop_t *d)
 	// }
 
 	unlink_node(node, d);
-	free(node->client);
+	pool_release(&d->client_pool, node->client);
 	node->client = NULL;
-	free(node);
+	pool_release(&d->node_pool, node);
 	node = NULL;
 
 out:
 	d->n_count -= 1;
-	if (!is_tree_empty(d->tree)) {
-		arrange_tree(d->tree, d->layout);
+	if (d->layout == MASTER && d->master_node == NULL) {
+		master_layout(d, NULL);
 	}
 	return;
 }
@@ -1377,126 +1242,61 @@ log_tree_nodes(node_t *node)
 }
 
 int
-hide_windows(node_t *cn)
+hide_windows(desktop_t *d)
 {
-	if (cn == NULL)
-		return 0;
-
-	if (!IS_INTERNAL(cn) && cn->client != NULL) {
-		if (hide_window(cn->client->window) != 0) {
+	for (node_t *cn = d->first_leaf; cn != NULL; cn = cn->next_leaf) {
+		/* windows that were already hidden keep their focus state and
+		 * button grabs from when they were hidden */
+		const bool was_mapped = cn->client->is_mapped;
+		if (hide_window(cn->client) != 0) {
 			return -1;
 		}
 
-		if (set_focus(cn, false) != 0) {
+		if (was_mapped && set_focus(cn, false) != 0) {
 			return -1;
 		}
 
-		if (!conf.focus_follow_pointer) {
+		if (was_mapped && !conf.focus_follow_pointer) {
 			window_grab_buttons(cn->client->window);
 		}
 	}
 
-	hide_windows(cn->first_child);
-	hide_windows(cn->second_child);
-
 	return 0;
 }
 
 int
-show_windows(node_t *cn)
+show_windows(desktop_t *d)
 {
-	if (cn == NULL)
-		return 0;
-
-	if (!IS_INTERNAL(cn) && cn->client != NULL) {
-		if (show_window(cn->client->window) != 0) {
+	for (node_t *cn = d->first_leaf; cn != NULL; cn = cn->next_leaf) {
+		if (show_window(cn->client) != 0) {
 			return -1;
 		}
 	}
 
-	show_windows(cn->first_child);
-	show_windows(cn->second_child);
-
 	return 0;
 }
 
 bool
 client_exist(node_t *cn, xcb_window_t win)
 {
-	if (cn == NULL)
-		return false;
-
-	if (cn->client != NULL) {
-		if (cn->client->window == win) {
-			return true;
-		}
-	}
-
-	if (client_exist(cn->first_child, win)) {
-		return true;
-	}
-
-	if (client_exist(cn->second_child, win)) {
-		return true;
-	}
-
-	return false;
+	return find_node_by_window_id(cn, win) != NULL;
 }
 
-static bool
-in_left_subtree(node_t *lc, node_t *n)
-{
-	if (lc == NULL)
-		return false;
-
-	if (lc == n || lc->first_child == n || lc->second_child == n) {
-		return true;
-	}
-
-	if (in_left_subtree(lc->first_child, n)) {
-		return true;
-	}
-
-	if (in_left_subtree(lc->second_child, n)) {
-		return true;
-	}
-
-	return false;
-}
-
-static bool
-in_right_subtree(node_t *rc, node_t *n)
-{
-	if (rc == NULL)
-		return false;
-
-	if (rc == n || rc->first_child == n || rc->second_child == n) {
-		return true;
-	}
-
-	if (in_right_subtree(rc->first_child, n)) {
-		return true;
-	}
-
-	if (in_right_subtree(rc->second_child, n)) {
-		return true;
-	}
-
-	return false;
-}
-
-int
-horizontal_resize_wrapper(arg_t *arg)
+/* a resize moves one split ratio, so only the subtree under that split
+ * is laid out and tiled again however deep the tree is. axis is the
+ * way the split to move divides its node, see layout_resize() */
+static int
+resize_wrapper(resize_t t, split_type_t axis)
 {
-	const int i = get_focused_desktop_idx();
-	if (i == -1)
-		return -1;
+	const int16_t px = 5;
+	desktop_t	 *d	 = cur_monitor->focused_desktop;
 
-	if (cur_monitor->desktops[i]->layout == STACK) {
+	/* split ratios only shape the default layout */
+	if (d->layout != DEFAULT) {
 		return 0;
 	}
 
-	node_t *root = cur_monitor->desktops[i]->tree;
+	node_t *root = d->tree;
 	if (root == NULL)
 		return -1;
 
@@ -1506,149 +1306,24 @@ horizontal_resize_wrapper(arg_t *arg)
 	if (n == NULL)
 		return -1;
 
-	horizontal_resize(n, arg->r);
-	render_tree(root);
+	/* dynamic splits are read from the rectangles on screen */
+	if (render_changes(d) != 0)
+		return -1;
+
+	mark_dirty(d, layout_resize(n, axis, t == GROW ? px : -px));
 	return 0;
 }
 
-static void
-horizontal_resize(node_t *n, resize_t t)
+int
+horizontal_resize_wrapper(arg_t *arg)
 {
-	const int16_t px			   = 5;
-	direction_t	  grow_direction   = NONE;
-	direction_t	  shrink_direction = NONE;
-
-	node_t		 *root			   = find_tree_root(n);
-
-	if (in_left_subtree(root->first_child, n)) {
-		grow_direction	 = RIGHT;
-		shrink_direction = LEFT;
-	} else if (in_right_subtree(root->second_child, n)) {
-		grow_direction	 = LEFT;
-		shrink_direction = RIGHT;
-	}
-
-	_LOG_(INFO, "dir == %d", grow_direction);
-
-	if (n->parent == NULL || IS_ROOT(n)) {
-		return;
-	}
-
-	/*
-	 * case 1: node's parent is the root.
-	 * I = Internal node
-	 * E = external node
-	 *
-	 * I's type is ROOT_NODE
-	 * Node to delete is E.
-	 * logic: grow E's width by 5 pixels
-	 * then move E's sibling x by 5 pixels and shrink its width by 5
-	 * pixels E's sibling can be External or Internal -> if internal,
-	 * resize its children
-	 *         I
-	 *    	 /   \
-	 *   	E     E/I
-	 *             \
-	 *            rest...
-	 */
-	if (IS_ROOT(n->parent)) {
-		node_t *s = NULL;
-		if (is_sibling_external(n)) {
-			s = get_external_sibling(n);
-			if (s == NULL)
-				return;
-
-			if (t == GROW) {
-				n->rectangle.width += px;
-				s->rectangle.width -= px;
-				grow_direction == RIGHT ? (s->rectangle.x += px)
-										: (n->rectangle.x -= px);
-			} else {
-				// shrink
-				n->rectangle.width -= px;
-				s->rectangle.width += px;
-				(shrink_direction == LEFT) ? (s->rectangle.x -= px)
-										   : (n->rectangle.x += px);
-			}
-		} else {
-			// sibling is internal
-			s = get_internal_sibling(n);
-			if (s == NULL) {
-				_LOG_(ERROR, "internal sibling is null");
-				return;
-			}
-			if (t == GROW) {
-				n->rectangle.width += px;
-				s->rectangle.width -= px;
-				grow_direction == RIGHT ? (s->rectangle.x += px)
-										: (n->rectangle.x -= px);
-				resize_subtree(s);
-			} else {
-				n->rectangle.width -= px;
-				s->rectangle.width += px;
-				(shrink_direction == LEFT) ? (s->rectangle.x -= px)
-										   : (n->rectangle.x += px);
-				resize_subtree(s);
-			}
-		}
-	}
-	/*
-	 * case 2: node's parent is not the root (it is INTERNAL_NODE).
-	 * I = Internal node
-	 * E = external node
-	 *
-	 * I's type is INTERNAL_NODE
-	 * Node to expand is E.
-	 * logic: grow the whole subtree(rectangle)'s width in E's side by
-	 * 5 pixels then move the opposite subtree(rectangle)'s x by 5
-	 * pixels and shrink its width by 5 pixels
-	 *         I
-	 *    	 /   \
-	 *   	I     E/I
-	 *    /   \     \
-	 *   E    E/I   rest...
-	 */
-	if (IS_INTERNAL(n->parent)) {
-		if (in_left_subtree(root->first_child, n)) {
-			if (root->first_child == NULL ||
-				!IS_INTERNAL(root->first_child)) {
-				return;
-			}
-			(t == GROW) ? (root->first_child->rectangle.width += px)
-						: (root->first_child->rectangle.width -= px);
-			(t == GROW) ? (root->second_child->rectangle.width -= px)
-						: (root->second_child->rectangle.width += px);
-			(t == GROW) ? (root->second_child->rectangle.x += px)
-						: (root->second_child->rectangle.x -= px);
+	return resize_wrapper(arg->r, VERTICAL_TYPE);
+}
 
-			if (root->second_child != NULL &&
-				IS_EXTERNAL(root->second_child)) {
-				resize_subtree(root->first_child);
-			} else {
-				resize_subtree(root->first_child);
-				resize_subtree(root->second_child);
-			}
-		} else {
-			if (root->second_child == NULL ||
-				!IS_INTERNAL(root->second_child)) {
-				return;
-			}
-			(t == GROW) ? (root->second_child->rectangle.width += px)
-						: (root->second_child->rectangle.width -= px);
-			(t == GROW) ? (root->second_child->rectangle.x -= px)
-						: (root->second_child->rectangle.x += px);
-			(t == GROW) ? (root->first_child->rectangle.width -= px)
-						: (root->first_child->rectangle.width += px);
-
-			if (root->first_child != NULL &&
-				IS_EXTERNAL(root->first_child)) {
-				resize_subtree(root->second_child);
-			} else {
-				resize_subtree(root->first_child);
-				resize_subtree(root->second_child);
-			}
-		}
-	}
+int
+vertical_resize_wrapper(arg_t *arg)
+{
+	return resize_wrapper(arg->r, HORIZONTAL_TYPE);
 }
 
 node_t *
@@ -1678,11 +1353,24 @@ unlink_node(node_t *node, desktop_t *d)
 	if (node == NULL)
 		return;
 
+	if (d->focused_node == node) {
+		d->focused_node = NULL;
+	}
+
+	if (d->master_node == node) {
+		update_master(d, NULL);
+	}
+
 	if (d->tree == node) {
+		leaf_remove(d, node);
 		d->tree = NULL;
 		return;
 	}
 
+	/* whichever way the tree is folded, the parent of node survives
+	 * and takes the space node had */
+	node_t *p = node->parent;
+
 	/* node to unlink = N, internal node = I, external node = E
 	 *         I
 	 *    	 /   \
@@ -1697,11 +1385,13 @@ unlink_node(node_t *node, desktop_t *d)
 		if (e == NULL) {
 			return;
 		}
+		leaf_remove(d, node);
 		// if I has no parent
 		if (IS_ROOT(node->parent)) {
 			node->parent->client	   = e->client;
 			node->parent->first_child  = NULL;
 			node->parent->second_child = NULL;
+			index_leaf(node->parent, d);
 		} else {
 			/* if I has a prent
 			 *         I
@@ -1716,17 +1406,22 @@ unlink_node(node_t *node, desktop_t *d)
 				g->first_child->client		 = e->client;
 				g->first_child->first_child	 = NULL;
 				g->first_child->second_child = NULL;
+				index_leaf(g->first_child, d);
 			} else {
 				g->second_child->node_type	  = EXTERNAL_NODE;
 				g->second_child->client		  = e->client;
 				g->second_child->first_child  = NULL;
 				g->second_child->second_child = NULL;
+				index_leaf(g->second_child, d);
 			}
 		}
+		leaf_replace(d, e, node->parent);
+		move_roles(d, e, node->parent);
 		e->parent = NULL;
-		free(e);
+		pool_release(&d->node_pool, e);
 		e			 = NULL;
 		node->parent = NULL;
+		mark_dirty(d, p);
 		return;
 	}
 	/*
@@ -1752,7 +1447,9 @@ unlink_node(node_t *node, desktop_t *d)
 	 * accordingly.
 	 */
 	if (is_sibling_internal(node)) {
-		node_t *n = NULL;
+		node_t *n	  = NULL;
+		node_t *after = node->next_leaf;
+		leaf_remove(d, node);
 		// if IN has no parent
 		if (IS_ROOT(node->parent)) {
 			n = get_internal_sibling(node);
@@ -1765,11 +1462,13 @@ unlink_node(node_t *node, desktop_t *d)
 				n->first_child->parent	= d->tree;
 				d->tree->second_child	= n->second_child;
 				n->second_child->parent = d->tree;
+				take_split(d->tree, n, false);
 			} else {
 				d->tree->second_child	= n->first_child;
 				n->first_child->parent	= d->tree;
 				d->tree->first_child	= n->second_child;
 				n->second_child->parent = d->tree;
+				take_split(d->tree, n, true);
 			}
 		} else {
 			// if IN has a parent
@@ -1795,19 +1494,30 @@ unlink_node(node_t *node, desktop_t *d)
 				n->first_child->parent	   = node->parent;
 				node->parent->second_child = n->second_child;
 				n->second_child->parent	   = node->parent;
+				take_split(node->parent, n, false);
 			} else {
+				/* E1 and E2 trade places here, so their leaves are
+				 * threaded again in the new order */
+				node_t *l = n;
+				while (l->first_child != NULL || l->second_child != NULL)
+					l = l->first_child ? l->first_child : l->second_child;
+				node_t *before = l->prev_leaf;
+
 				node->parent->second_child = n->first_child;
 				n->first_child->parent	   = node->parent;
 				node->parent->first_child  = n->second_child;
 				n->second_child->parent	   = node->parent;
+				take_split(node->parent, n, true);
+				thread_subtree(d, node->parent, before, after);
 			}
 		}
 		n->parent		= NULL;
 		n->first_child	= NULL;
 		n->second_child = NULL;
 		node->parent	= NULL;
-		free(n);
+		pool_release(&d->node_pool, n);
 		n = NULL;
+		mark_dirty(d, p);
 	}
 }
 
@@ -1819,13 +1529,11 @@ transfer_node_wrapper(arg_t *arg)
 	if (w == wm->root_window)
 		return -1;
 
-	int d = get_focused_desktop_idx();
-	if (d == -1)
-		return d;
+	const uint32_t d = get_focused_desktop_idx();
 
-	const int i	   = arg->idx;
-	node_t	 *root = cur_monitor->desktops[d]->tree;
-	node_t	 *node = find_node_by_window_id(root, w);
+	const uint32_t i	= arg->idx;
+	node_t		  *root = cur_monitor->desktops[d]->tree;
+	node_t		  *node = find_node_by_window_id(root, w);
 
 	if (d == i) {
 		return 0;
@@ -1834,30 +1542,53 @@ transfer_node_wrapper(arg_t *arg)
 	desktop_t *nd = cur_monitor->desktops[i];
 	desktop_t *od = cur_monitor->desktops[d];
 #ifdef _DEBUG__
-	_LOG_(DEBUG, "new desktop = %d, old desktop = %d", i + 1, d + 1);
+	_LOG_(DEBUG, "new desktop = %u, old desktop = %u", i + 1, d + 1);
 #endif
-	if (hide_window(node->client->window) != 0) {
+	if (hide_window(node->client) != 0) {
+		return -1;
+	}
+	node = move_node(node, od, nd);
+	if (node == NULL) {
+		_LOG_(ERROR, "cannot move window %d to desktop %u", w, i + 1);
 		return -1;
 	}
-	unlink_node(node, od);
-	transfer_node(node, nd);
 
 	if (nd->layout == STACK) {
 		set_focus(node, true);
+		update_focus(nd, node);
 		nd->top_w = node->client->window;
 	}
 
 	od->n_count--;
 	nd->n_count++;
+	return 0;
+}
 
-	if (render_tree(od->tree) != 0) {
-		return -1;
+/* unlinks node from one desktop and links it into another. the node and
+ * its client are copied into the pools of the new desktop on the way,
+ * so the node handed back replaces the one passed in */
+static node_t *
+move_node(node_t *node, desktop_t *from, desktop_t *to)
+{
+	node_t	 *n = (node_t *)pool_alloc(&to->node_pool);
+	client_t *c = (client_t *)pool_alloc(&to->client_pool);
+	if (n == NULL || c == NULL) {
+		pool_release(&to->node_pool, n);
+		pool_release(&to->client_pool, c);
+		return NULL;
 	}
-	return 0;
+
+	unlink_node(node, from);
+	*c		  = *node->client;
+	*n		  = *node;
+	n->client = c;
+	pool_release(&from->client_pool, node->client);
+	pool_release(&from->node_pool, node);
+
+	transfer_node(n, to);
+	return n;
 }
 
-// TODO: handle transfer in master layout
-// TODO: handle transfer in stack layout
 void
 transfer_node(node_t *node, desktop_t *d)
 {
@@ -1872,41 +1603,31 @@ transfer_node(node_t *node, desktop_t *d)
 	assert(node->parent == NULL);
 
 	if (is_tree_empty(d->tree)) {
-		rectangle_t	   r = {0};
-		// uint16_t	w = wm->screen->width_in_pixels;
-		// uint16_t	h = wm->screen->height_in_pixels;
-		uint16_t	   w = cur_monitor->rectangle.width;
-		uint16_t	   h = cur_monitor->rectangle.height;
-		const uint16_t x = cur_monitor->rectangle.x;
-		const uint16_t y = cur_monitor->rectangle.y;
-		if (wm->bar != NULL && cur_monitor == prim_monitor) {
-			r.x		 = x + conf.window_gap;
-			r.y		 = y + wm->bar->rectangle.height + conf.window_gap;
-			r.width	 = w - 2 * conf.window_gap - 2 * conf.border_width;
-			r.height = h - wm->bar->rectangle.height -
-					   2 * conf.window_gap - 2 * conf.border_width;
-		} else {
-			r.x		 = x + conf.window_gap;
-			r.y		 = y + conf.window_gap;
-			r.width	 = w - 2 * conf.window_gap - 2 * conf.border_width;
-			r.height = h - 2 * conf.window_gap - 2 * conf.border_width;
-		}
-		node->node_type	   = ROOT_NODE;
-		d->tree			   = node;
-		d->tree->rectangle = r;
+		const layout_params_t lp   = get_layout_params();
+		const rectangle_t	  area = desktop_area(d);
+		node->node_type			   = ROOT_NODE;
+		d->tree					   = node;
+		d->tree->rectangle		   = layout_root_rect(area, &lp);
 		d->tree->node_type = ROOT_NODE;
+		relink_leaves(d);
+		mark_dirty(d, d->tree);
 	} else if (d->tree->first_child == NULL &&
 			   d->tree->second_child == NULL) {
 		client_t *c = d->tree->client;
-		if ((d->tree->first_child = create_node(c)) == NULL) {
+		reset_split(d->tree);
+		if ((d->tree->first_child = create_node(c, d)) == NULL) {
 			return;
 		}
+		move_roles(d, d->tree, d->tree->first_child);
 		d->tree->first_child->node_type	 = EXTERNAL_NODE;
 		d->tree->second_child			 = node;
 		d->tree->second_child->node_type = EXTERNAL_NODE;
 		d->tree->client					 = NULL;
 		d->tree->first_child->parent	 = d->tree->second_child->parent =
 			d->tree;
+		thread_split(d, d->tree);
+		index_leaf(d->tree->first_child, d);
+		mark_dirty(d, d->tree);
 	} else {
 		node_t *leaf = find_left_leaf(d->tree);
 		if (leaf == NULL) {
@@ -1915,10 +1636,12 @@ transfer_node(node_t *node, desktop_t *d)
 		if (!IS_ROOT(leaf)) {
 			leaf->node_type = INTERNAL_NODE;
 		}
-		leaf->first_child = create_node(leaf->client);
+		reset_split(leaf);
+		leaf->first_child = create_node(leaf->client, d);
 		if (leaf->first_child == NULL) {
 			return;
 		}
+		move_roles(d, leaf, leaf->first_child);
 		leaf->first_child->parent	 = leaf;
 		leaf->first_child->node_type = EXTERNAL_NODE;
 		leaf->client				 = NULL;
@@ -1929,8 +1652,14 @@ transfer_node(node_t *node, desktop_t *d)
 		}
 		leaf->second_child->parent	  = leaf;
 		leaf->second_child->node_type = EXTERNAL_NODE;
+		thread_split(d, leaf);
+		index_leaf(leaf->first_child, d);
+		mark_dirty(d, leaf);
+	}
+	index_leaf(node, d);
+	if (d->layout == MASTER && d->master_node == NULL) {
+		master_layout(d, NULL);
 	}
-	arrange_tree(d->tree, d->layout);
 }
 
 bool
@@ -1960,29 +1689,7 @@ next_node(node_t *n)
 	if (n == NULL)
 		return NULL;
 
-	if (n->parent && n->parent->second_child != n) {
-		node_t *l = n->parent->second_child;
-		while (!IS_EXTERNAL(l)) {
-			l = l->first_child;
-		}
-		return l;
-	}
-
-	node_t *c = n;
-	node_t *p = c->parent;
-	while (p && p->second_child == c) {
-		c = p;
-		p = c->parent;
-	}
-
-	if (p == NULL)
-		return NULL;
-
-	node_t *r = p->second_child;
-	while (!IS_EXTERNAL(r)) {
-		r = r->first_child;
-	}
-	return r;
+	return n->next_leaf;
 }
 
 node_t *
@@ -1991,258 +1698,62 @@ prev_node(node_t *n)
 	if (n == NULL)
 		return NULL;
 
-	if (n->parent && n->parent->first_child != n) {
-		node_t *l = n->parent->first_child;
-		while (!IS_EXTERNAL(l)) {
-			if (l->second_child) {
-				l = l->second_child;
-			} else {
-				l = l->first_child;
-			}
-		}
-		return l;
-	}
-
-	node_t *c = n;
-	node_t *p = c->parent;
-	while (p && p->first_child == c) {
-		c = p;
-		p = c->parent;
-	}
-
-	if (p == NULL)
-		return NULL;
-
-	node_t *l = p->first_child;
-	while (!IS_EXTERNAL(l)) {
-		if (l->second_child) {
-			l = l->second_child;
-		} else {
-			l = l->first_child;
-		}
-	}
-	return l;
-}
-
-void
-flip_node(node_t *node)
-{
-	if (node->parent == NULL) {
-		return;
-	}
-	flip_t	flip = (node->rectangle.width >= node->rectangle.height)
-					   ? VERTICAL_FLIP
-					   : HORIZONTAL_FLIP;
-	node_t *p	 = node->parent;
-	node_t *s =
-		(p->first_child == node) ? p->second_child : p->first_child;
-
-	if (s == NULL)
-		return;
-
-	node->rectangle.x = p->rectangle.x;
-	node->rectangle.y = p->rectangle.y;
-	node->rectangle.width =
-		(flip == VERTICAL_FLIP)
-			? ((p->rectangle.width - conf.window_gap) / 2)
-			: p->rectangle.width;
-	node->rectangle.height =
-		(flip == VERTICAL_FLIP)
-			? p->rectangle.height
-			: (p->rectangle.height - conf.window_gap) / 2;
-	s->rectangle.x =
-		(flip == VERTICAL_FLIP)
-			? ((int16_t)((p->rectangle.x + node->rectangle.width) +
-						 conf.window_gap))
-			: p->rectangle.x;
-	s->rectangle.y =
-		(flip == VERTICAL_FLIP)
-			? p->rectangle.y
-			: ((int16_t)((p->rectangle.y + node->rectangle.height) +
-						 conf.window_gap));
-	s->rectangle.width =
-		(flip == VERTICAL_FLIP)
-			? ((p->rectangle.width - node->rectangle.width) -
-			   conf.window_gap)
-			: p->rectangle.width;
-	s->rectangle.height =
-		(flip == VERTICAL_FLIP)
-			? p->rectangle.height
-			: ((p->rectangle.height - node->rectangle.height) -
-			   conf.window_gap);
-
-	if (s->node_type == INTERNAL_NODE) {
-		resize_subtree(s);
-	}
+	return n->prev_leaf;
 }
 
 void
-update_focus(node_t *root, node_t *n)
+flip_node(node_t *node, desktop_t *d)
 {
-	if (root == NULL)
-		return;
-
-	bool flag = !IS_INTERNAL(root) && root->client != NULL;
-	if (flag && root != n) {
-		set_focus(root, false);
-		if (!conf.focus_follow_pointer)
-			window_grab_buttons(root->client->window);
-		root->is_focused = false;
-	}
-
-	update_focus(root->first_child, n);
-	update_focus(root->second_child, n);
+	layout_flip(node);
+	mark_dirty(d, node->parent);
 }
 
+/* the desktop remembers which node holds focus, so moving it only
+ * needs to touch the previous holder rather than every other leaf */
 void
-update_focus_all(node_t *root)
+update_focus(desktop_t *d, node_t *n)
 {
-	if (root == NULL)
-		return;
-
-	bool flag = !IS_INTERNAL(root) && root->client != NULL;
-	if (flag) {
-		set_focus(root, false);
+	node_t *old = d->focused_node;
+	if (old != NULL && old != n && old->client != NULL) {
+		set_focus(old, false);
 		if (!conf.focus_follow_pointer)
-			window_grab_buttons(root->client->window);
-		root->is_focused = false;
+			window_grab_buttons(old->client->window);
 	}
-
-	update_focus_all(root->first_child);
-	update_focus_all(root->second_child);
-}
-
-node_t *
-get_focused_node(node_t *n)
-{
-	if (n == NULL)
-		return NULL;
-
-	if (n->client != NULL && n->is_focused) {
-		return n;
-	}
-
-	node_t *l = get_focused_node(n->first_child);
-	if (l != NULL) {
-		return l;
-	}
-	node_t *s = get_focused_node(n->second_child);
-	if (s != NULL) {
-		return s;
-	}
-
-	return NULL;
+	d->focused_node = n;
 }
 
+/* the two children of the parent of n trade places, and the split
+ * keeps each side the size it had */
 int
-swap_node(node_t *n)
+swap_node(node_t *n, desktop_t *d)
 {
-	if (n->parent == NULL)
+	node_t *p = n->parent;
+	if (p == NULL || p->first_child == NULL || p->second_child == NULL)
 		return -1;
 
-	node_t	   *s = (n->parent->first_child == n) ? n->parent->second_child
-												  : n->parent->first_child;
-	rectangle_t sr = s->rectangle;
-	rectangle_t nr = n->rectangle;
-	n->rectangle   = sr;
-	s->rectangle   = nr;
-
-	if (IS_INTERNAL(s)) {
-		resize_subtree(s);
-	}
+	node_t *l = p;
+	while (l->first_child != NULL || l->second_child != NULL)
+		l = l->first_child ? l->first_child : l->second_child;
+	node_t *r = p;
+	while (r->first_child != NULL || r->second_child != NULL)
+		r = r->second_child ? r->second_child : r->first_child;
+	node_t *before = l->prev_leaf;
+	node_t *after  = r->next_leaf;
+
+	node_t *first	= p->first_child;
+	p->first_child	= p->second_child;
+	p->second_child = first;
+	p->split_ratio	= 1 - p->split_ratio;
+	thread_subtree(d, p, before, after);
+	mark_dirty(d, p);
 
 	return 0;
 }
 
-static bool
-is_within_range(rectangle_t *rect1, rectangle_t *rect2, direction_t d)
-{
-	switch (d) {
-	case LEFT:
-		return rect2->x + rect2->width <= rect1->x &&
-			   rect1->y < rect2->y + rect2->height &&
-			   rect1->y + rect1->height > rect2->y;
-	case RIGHT:
-		return rect2->x >= rect1->x + rect1->width &&
-			   rect1->y < rect2->y + rect2->height &&
-			   rect1->y + rect1->height > rect2->y;
-	case UP:
-		return rect2->y + rect2->height <= rect1->y &&
-			   rect1->x < rect2->x + rect2->width &&
-			   rect1->x + rect1->width > rect2->x;
-	case DOWN:
-		return rect2->y >= rect1->y + rect1->height &&
-			   rect1->x < rect2->x + rect2->width &&
-			   rect1->x + rect1->width > rect2->x;
-	default: return false;
-	}
-}
-
-static node_t *
-find_closest_neighbor(node_t *root, node_t *node, direction_t d)
-{
-	if (root == NULL)
-		return NULL;
-
-	node_t *closest			 = NULL;
-	int		closest_distance = INT16_MAX;
-
-	node_t *queue[50];
-	int		front = 0, rear = 0;
-	queue[rear++] = root;
-
-	while (front < rear) {
-		node_t *current = queue[front++];
-
-		if (current == node)
-			continue;
-		if (IS_EXTERNAL(current) && current->client != NULL &&
-			is_within_range(&node->rectangle, &current->rectangle, d)) {
-			int distance;
-			switch (d) {
-			case LEFT:
-				distance = node->rectangle.x - (current->rectangle.x +
-												current->rectangle.width);
-				break;
-			case RIGHT:
-				distance = current->rectangle.x -
-						   (node->rectangle.x + node->rectangle.width);
-				break;
-			case UP:
-				distance = node->rectangle.y - (current->rectangle.y +
-												current->rectangle.height);
-				break;
-			case DOWN:
-				distance = current->rectangle.y -
-						   (node->rectangle.y + node->rectangle.height);
-				break;
-			default: distance = INT16_MAX; break;
-			}
-			if (distance < closest_distance) {
-				closest_distance = distance;
-				closest			 = current;
-			}
-		}
-
-		if (current->first_child != NULL)
-			queue[rear++] = current->first_child;
-		if (current->second_child != NULL)
-			queue[rear++] = current->second_child;
-	}
-
-	return closest;
-}
-
 node_t *
-cycle_win(node_t *node, direction_t d)
+cycle_win(desktop_t *dsk, node_t *node, direction_t d)
 {
-	node_t *root = find_tree_root(node);
-	if (root == NULL) {
-		_LOG_(ERROR, "could not find root of tree");
-		return NULL;
-	}
-
-	node_t *neighbor = find_closest_neighbor(root, node, d);
+	node_t *neighbor = spatial_nearest(dsk, node, d);
 	if (neighbor == NULL) {
 		_LOG_(ERROR, "could not find neighbor node");
 		return NULL;
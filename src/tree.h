@@ -31,38 +31,38 @@
 
 #include "type.h"
 // clang-format off
-node_t   *create_node(client_t *c);
-node_t   *init_root(void);
+node_t   *create_node(client_t *c, desktop_t *d);
+node_t   *init_root(desktop_t *d);
 node_t   *find_node_by_window_id(node_t *root, xcb_window_t window_id);
-node_t   *find_master_node(node_t *root);
 node_t   *prev_node(node_t *current);
 node_t   *next_node(node_t *current);
-node_t   *cycle_win(node_t *node, direction_t);
+node_t   *cycle_win(desktop_t *dsk, node_t *node, direction_t);
 node_t   *find_left_leaf(node_t *root);
-node_t 	 *get_focused_node(node_t *n);
 void     unlink_node(node_t *node, desktop_t *d);
-void 	 apply_master_layout(node_t *parent);
-void 	 apply_default_layout(node_t *root);
-void	 apply_stack_layout(node_t *root);
-void	 update_focus(node_t *root, node_t *n);
-void	 flip_node(node_t *node);
-void	 resize_subtree(node_t *parent);
+void	 update_focus(desktop_t *d, node_t *n);
+void	 update_master(desktop_t *d, node_t *n);
+void	 flip_node(node_t *node, desktop_t *d);
 void	 apply_layout(desktop_t *d, layout_t t);
-void	 free_tree(node_t *root);
+void	 arrange_tree(desktop_t *d);
+void	 mark_dirty(desktop_t *d, node_t *n);
+void	 free_tree(desktop_t *d);
+void	 relink_leaves(desktop_t *d);
 void	 restack(void);
 void     restackv2(node_t *root);
 void	 delete_node(node_t *node, desktop_t *d);
-void	 insert_node(node_t *current_node, node_t *new_node, layout_t layout);
+void	 insert_node(node_t *current_node, node_t *new_node, desktop_t *d);
 void	 log_tree_nodes(node_t *node);
 void	 transfer_node(node_t *, desktop_t *);
 bool	 is_tree_empty(const node_t *root);
 bool	 client_exist(node_t *cn, xcb_window_t id);
 bool	 has_floating_window(node_t *root);
-int	   	 render_tree(node_t *current_node);
-int		 hide_windows(node_t *tree);
-int 	 show_windows(node_t *tree);
+int	   	 render_tree(desktop_t *d);
+int		 render_changes(desktop_t *d);
+int		 hide_windows(desktop_t *d);
+int 	 show_windows(desktop_t *d);
 int	     transfer_node_wrapper(arg_t *arg);
 int 	 horizontal_resize_wrapper(arg_t *arg);
-int	     swap_node(node_t *root);
+int 	 vertical_resize_wrapper(arg_t *arg);
+int	     swap_node(node_t *n, desktop_t *d);
 // clang-format on
 #endif // ZWM_TREE_H
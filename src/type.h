@@ -46,10 +46,16 @@
 #define NORMAL_BORDER_COLOR	 0x30302f
 #define ACTIVE_BORDER_COLOR	 0x83a598
 #define BORDER_WIDTH		 2
+#define MASTER_RATIO		 0.70
+#define SPLIT_RATIO			 0.50
+#define MIN_SPLIT_RATIO		 0.10
 #define FOCUS_FOLLOW_POINTER true
 
 typedef xcb_connection_t xcb_conn_t;
 
+/* how a node divides its rectangle: VERTICAL_TYPE puts the children
+ * side by side, HORIZONTAL_TYPE one above the other and DYNAMIC_TYPE
+ * picks by the shape of the rectangle every time it is laid out */
 typedef enum {
 	HORIZONTAL_TYPE,
 	VERTICAL_TYPE,
@@ -91,6 +97,35 @@ typedef enum {
 	CURSOR_MAX
 } cursor_t;
 
+typedef enum {
+	ATOM_WM_STATE = 0,
+	ATOM_WM_DELETE_WINDOW,
+	ATOM_MAX
+} atom_t;
+
+typedef enum {
+	OP_CHANGE_ATTRIBUTES = 0,
+	OP_CONFIGURE,
+	OP_RESTACK,
+	OP_SET_INPUT_FOCUS,
+	OP_MAP,
+	OP_UNMAP,
+	OP_CHANGE_PROPERTY,
+	OP_SET_ACTIVE_WINDOW,
+	OP_GRAB_BUTTON,
+	OP_UNGRAB_BUTTON,
+	OP_KILL_CLIENT,
+	OP_MAX
+} x_op_t;
+
+/* an unchecked request still in flight, keyed by its sequence number so
+ * an error event coming back from the server can be matched to it */
+typedef struct {
+	uint32_t	 sequence;
+	xcb_window_t window;
+	x_op_t		 op;
+} x_request_t;
+
 typedef struct {
 	// 2^16 = 65535
 	uint16_t previous_x, previous_y;
@@ -104,6 +139,15 @@ typedef struct {
 	uint16_t height;
 } rectangle_t;
 
+/* last pointer position and top-level window under it, as reported by
+ * enter, motion, button and key events */
+typedef struct {
+	int16_t		 root_x;
+	int16_t		 root_y;
+	xcb_window_t window;
+	bool		 is_stale;
+} pointer_state_t;
+
 typedef enum {
 	TILED,
 	FLOATING,
@@ -117,11 +161,32 @@ typedef enum {
 	GRID
 } layout_t;
 
+/* what handle_map_request needs to know about a new window, collected
+ * from a single burst of requests by classify_window(). managed clients
+ * keep a copy that PropertyNotify keeps current */
 typedef struct {
+	char		 name[MAXLEN];
+	char		 class_name[MAXLEN];
+	char		 instance_name[MAXLEN];
+	xcb_window_t transient_for;
+	int			 type;
+	bool		 override_redirect;
+	bool		 fixed_size;
+	bool		 supports_delete;
+} win_class_t;
+
+typedef struct {
+	/* what was last sent to the server for this window, so tile() can
+	 * skip requests that would not change anything */
 	uint32_t	 border_width;
+	uint32_t	 border_color;
+	uint32_t	 wm_state;
+	rectangle_t	 applied;
+	bool		 is_mapped;
 	xcb_window_t window;
 	xcb_atom_t	 type;
 	state_t		 state;
+	win_class_t	 props;
 } client_t;
 
 typedef enum {
@@ -181,28 +246,113 @@ typedef enum {
 
 typedef struct node_t node_t;
 struct node_t {
-	node_t	   *parent;
-	node_t	   *first_child;
-	node_t	   *second_child;
-	client_t   *client;
-	node_type_t node_type;
-	rectangle_t rectangle;
-	rectangle_t floating_rectangle;
-	bool		is_focused;
-	bool		is_master;
+	node_t		*parent;
+	node_t		*first_child;
+	node_t		*second_child;
+	/* neighbouring leaves in in-order sequence, see desktop_t */
+	node_t		*prev_leaf;
+	node_t		*next_leaf;
+	client_t	*client;
+	node_type_t	 node_type;
+	rectangle_t	 rectangle;
+	rectangle_t	 floating_rectangle;
+	/* for internal nodes: the way the rectangle is divided and the
+	 * share of it the first child gets */
+	split_type_t split_type;
+	double		 split_ratio;
+	bool		 is_focused;
+	bool		 is_master;
+	/* is_dirty: the rectangle changed and the subtree must be laid out
+	 * again from it. is_dirty_below: some descendant is dirty. both are
+	 * cleared by the next layout pass, see layout_dirty() */
+	bool		 is_dirty;
+	bool		 is_dirty_below;
+};
+
+/* called by the layout pass for each leaf it laid out */
+typedef void (*leaf_visit_t)(node_t *leaf, void *arg);
+
+/* what the layout code reads besides the tree and the area it tiles */
+typedef struct {
+	uint16_t window_gap;
+	uint16_t border_width;
+	double	 master_ratio;
+} layout_params_t;
+
+/* what a desktop was last fully laid out for. the rectangles in its
+ * tree are that layout for as long as the key still matches, so
+ * arrange_tree() can leave them alone */
+typedef struct {
+	rectangle_t		area;
+	layout_params_t params;
+	uint32_t		generation;
+	layout_t		layout;
+	bool			is_valid;
+} layout_key_t;
+
+/* one leaf seen from one direction: key is the edge facing that way,
+ * negated for LEFT and UP so every direction searches upwards, and
+ * lo/hi is the leaf's extent on the other axis */
+typedef struct {
+	int32_t key;
+	int32_t lo;
+	int32_t hi;
+	node_t *node;
+} spatial_entry_t;
+
+#define SPATIAL_AXES 4
+
+/* the leaves of a desktop sorted by each of their four edges, indexed
+ * by direction - LEFT */
+typedef struct {
+	spatial_entry_t *edges[SPATIAL_AXES];
+	uint32_t		 len;
+	uint32_t		 cap;
+	bool			 is_valid;
+} spatial_t;
+
+typedef struct pool_slab_t pool_slab_t;
+struct pool_slab_t {
+	pool_slab_t *next;
 };
 
+/* fixed-size object pool; n_live objects are handed out and n_pooled
+ * free slots are waiting on free_list */
+typedef struct {
+	pool_slab_t *slabs;
+	void		*free_list;
+	size_t		 obj_size;
+	uint32_t	 n_live;
+	uint32_t	 n_pooled;
+} pool_t;
+
+typedef struct monitor_t monitor_t;
+
 typedef struct {
 	node_t		*tree;
+	/* the monitor whose desktops array holds this desktop */
+	monitor_t	*monitor;
+	node_t		*focused_node;
+	node_t		*master_node;
+	/* ends of the leaf list threaded through node_t */
+	node_t		*first_leaf;
+	node_t		*last_leaf;
 	xcb_window_t top_w;
 	char		 name[DLEN];
-	uint8_t		 id;
-	uint8_t		 n_count;
+	uint32_t	 id;
+	uint32_t	 n_count;
+	/* bumped by every change to the shape of the tree and by changes
+	 * to its rectangles made outside a full layout */
+	uint32_t	 generation;
 	layout_t	 layout;
 	bool		 is_focused;
+	bool		 is_dirty;
+	pool_t		 node_pool;
+	pool_t		 client_pool;
+	spatial_t	 spatial;
+	layout_key_t laid_out;
 } desktop_t;
 
-typedef struct monitor_t monitor_t;
 struct monitor_t {
 	desktop_t		 **desktops;
 	monitor_t		  *next;
@@ -215,9 +365,22 @@ struct monitor_t {
 	bool			   is_focused;
 	bool			   is_occupied;
 	bool			   is_primary;
-	uint8_t			   n_of_desktops;
+	uint32_t		   n_of_desktops;
+	/* the desktop shown on this monitor and its index in desktops,
+	 * kept in step with the desktops' is_focused flags */
+	uint32_t		   focused_desktop_idx;
+	desktop_t		  *focused_desktop;
 };
 
+/* a live window and, once it is managed, where it sits in the trees.
+ * monitor, desktop and node stay NULL for windows zwm does not manage */
+typedef struct {
+	xcb_window_t window;
+	monitor_t	*monitor;
+	desktop_t	*desktop;
+	node_t		*node;
+} registry_entry_t;
+
 typedef struct {
 	uint32_t	 id;
 	xcb_window_t window;
@@ -237,7 +400,7 @@ typedef struct {
 typedef struct {
 	char	  **cmd;
 	uint8_t		argc;
-	uint8_t		idx;
+	uint32_t	idx;
 	resize_t	r;
 	layout_t	t;
 	direction_t d;
@@ -32,6 +32,10 @@
 #include "zwm.h"
 #include "config_parser.h"
 #include "helper.h"
+#include "layout.h"
+#include "monitor.h"
+#include "pool.h"
+#include "registry.h"
 #include "tree.h"
 #include "type.h"
 #include <X11/keysym.h>
@@ -54,8 +58,6 @@
 #define XCB_MOVE_RESIZE                                                   \
 	(XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y |                          \
 	 XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT)
-#define XCB_MOVE   (XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y)
-#define XCB_RESIZE (XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT)
 #define SUBSTRUCTURE_REDIRECTION                                          \
 	(XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY |                                 \
 	 XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT)
@@ -75,6 +77,7 @@
 #define SHIFT_MASK		   XCB_MOD_MASK_SHIFT
 #define CTRL_MASK		   XCB_MOD_MASK_CONTROL
 #define CLICK_TO_FOCUS	   XCB_BUTTON_INDEX_1
+#define REQUEST_RING_SIZE  (2 << 8)
 
 wm_t				 *wm			 = NULL;
 config_t			  conf			 = {0};
@@ -89,6 +92,12 @@ bool				  using_xinerama = false;
 uint8_t				  randr_base	 = 0;
 xcb_cursor_context_t *cursor_ctx;
 xcb_cursor_t		  cursors[CURSOR_MAX];
+xcb_atom_t			  atom_table[ATOM_MAX];
+static x_request_t	  request_ring[REQUEST_RING_SIZE];
+#ifdef _DEBUG__
+static uint32_t request_counts[OP_MAX];
+#endif
+static pointer_state_t pointer = {.is_stale = true};
 
 // clang-format off
 // X11/keysymdef.h
@@ -112,6 +121,9 @@ static const _key__t keys_[] = {
 	{SUPER_MASK,              XK_Up,     cycle_win_wrapper,         &((arg_t){.d = UP})        },
 	{SUPER_MASK,              XK_Down,   cycle_win_wrapper,         &((arg_t){.d = DOWN})      },
 	{SUPER_MASK,              XK_l,      horizontal_resize_wrapper, &((arg_t){.r = GROW})      },
+	{SUPER_MASK,              XK_h,      horizontal_resize_wrapper, &((arg_t){.r = SHRINK})    },
+	{SUPER_MASK,              XK_k,      vertical_resize_wrapper,   &((arg_t){.r = GROW})      },
+	{SUPER_MASK,              XK_j,      vertical_resize_wrapper,   &((arg_t){.r = SHRINK})    },
 	{SUPER_MASK,              XK_f,      set_fullscreen_wrapper,    NULL                       },
 	{SUPER_MASK,              XK_s,      swap_node_wrapper,         NULL                       },
 	{SUPER_MASK | SHIFT_MASK, XK_1,      transfer_node_wrapper,     &((arg_t){.idx = 0})       },
@@ -124,6 +136,7 @@ static const _key__t keys_[] = {
 	{SUPER_MASK | SHIFT_MASK, XK_m,      layout_handler,            &((arg_t){.t = MASTER})    },
     {SUPER_MASK | SHIFT_MASK, XK_d,      layout_handler,            &((arg_t){.t = DEFAULT})   },
     {SUPER_MASK | SHIFT_MASK, XK_s,      layout_handler,            &((arg_t){.t = STACK})     },
+	{SUPER_MASK | SHIFT_MASK, XK_g,      layout_handler,            &((arg_t){.t = GRID})      },
 	{SUPER_MASK | SHIFT_MASK, XK_k,      traverse_stack_wrapper,    &((arg_t){.d = UP})        },
     {SUPER_MASK | SHIFT_MASK, XK_j,      traverse_stack_wrapper,    &((arg_t){.d = DOWN})      },
     {SUPER_MASK | SHIFT_MASK, XK_f,      flip_node_wrapper,   		NULL            		   },
@@ -138,9 +151,8 @@ static const uint32_t buttons_[] = {
 static monitor_t *get_focused_monitor();
 static int set_fullscreen(node_t *, bool);
 static int change_border_attr(xcb_conn_t *, xcb_window_t, uint32_t, uint32_t, bool);
-static int resize_window(xcb_window_t, uint16_t x, uint16_t y);
-static int move_window(xcb_window_t, int16_t x, int16_t y);
-static int win_focus(xcb_window_t, bool);
+static int move_resize_window(xcb_window_t, rectangle_t r);
+static int win_focus(client_t *, bool);
 static void update_grabbed_window(node_t *, node_t *);
 static void ungrab_keys(xcb_conn_t *, xcb_window_t);
 static int grab_keys(xcb_conn_t *, xcb_window_t);
@@ -153,12 +165,18 @@ static int change_border_attr(xcb_conn_t *, xcb_window_t, uint32_t, uint32_t, bo
 static int change_window_attr(xcb_conn_t *, xcb_window_t, uint32_t, const void *);
 static int configure_window(xcb_conn_t *, xcb_window_t, uint16_t, const void *);
 static int set_input_focus(xcb_conn_t *, uint8_t, xcb_window_t, xcb_timestamp_t);
-static xcb_atom_t get_atom(char *, xcb_conn_t *);
+static xcb_atom_t get_atom(atom_t);
 static bool window_exists(xcb_conn_t *, xcb_window_t);
+static bool seed_registry(void);
+static client_t *find_managed_client(xcb_window_t);
+static void invalidate_pointer(void);
+static bool refresh_pointer(xcb_conn_t *);
 static int close_or_kill(xcb_window_t);
 static int switch_desktop(const int);
-static int handle_tiled_window_request(xcb_window_t, desktop_t *);
-static int handle_floating_window_request(xcb_window_t, desktop_t *);
+static int switch_monitor_desktop(monitor_t *, uint32_t);
+static int set_window_state(client_t *, xcb_icccm_wm_state_t);
+static int handle_tiled_window_request(xcb_window_t, const win_class_t *, desktop_t *);
+static int handle_floating_window_request(xcb_window_t, const win_class_t *, desktop_t *);
 static int handle_bar_request(xcb_window_t, desktop_t *);
 // clang-format on
 
@@ -208,6 +226,96 @@ set_cursor(int cursor_id)
 	xcb_flush(wm->connection);
 }
 
+/*
+ * Requests on the hot paths are sent unchecked, so a failure comes back
+ * as an error event in event_loop instead of blocking the caller on a
+ * round trip. Each request is remembered here by its sequence number so
+ * the error can be traced back to the window and operation that caused
+ * it. Slots are reused once the ring wraps; by then the server has long
+ * answered the old request.
+ */
+static void
+track_request(xcb_void_cookie_t c, xcb_window_t win, x_op_t op)
+{
+	x_request_t *r = &request_ring[c.sequence & (REQUEST_RING_SIZE - 1)];
+	r->sequence	   = c.sequence;
+	r->window	   = win;
+	r->op		   = op;
+#ifdef _DEBUG__
+	request_counts[op]++;
+#endif
+}
+
+static const char *
+x_op_name(x_op_t op)
+{
+	static const char *names[OP_MAX] = {
+		[OP_CHANGE_ATTRIBUTES] = "change attributes",
+		[OP_CONFIGURE]		   = "configure",
+		[OP_RESTACK]		   = "restack",
+		[OP_SET_INPUT_FOCUS]   = "set input focus",
+		[OP_MAP]			   = "map",
+		[OP_UNMAP]			   = "unmap",
+		[OP_CHANGE_PROPERTY]   = "change property",
+		[OP_SET_ACTIVE_WINDOW] = "set active window",
+		[OP_GRAB_BUTTON]	   = "grab button",
+		[OP_UNGRAB_BUTTON]	   = "ungrab button",
+		[OP_KILL_CLIENT]	   = "kill client",
+	};
+	return (op < OP_MAX && names[op] != NULL) ? names[op] : "unknown";
+}
+
+#ifdef _DEBUG__
+/* how many ConfigureWindow requests the last batch of events cost */
+static void
+log_request_counts(void)
+{
+	const uint32_t n =
+		request_counts[OP_CONFIGURE] + request_counts[OP_RESTACK];
+	if (n > 0) {
+		_LOG_(DEBUG,
+			  "batch sent %u ConfigureWindow, %u MapWindow requests",
+			  n,
+			  request_counts[OP_MAP]);
+	}
+	memset(request_counts, 0, sizeof(request_counts));
+}
+#endif
+
+static void
+handle_x_error(const xcb_generic_error_t *e)
+{
+	const x_request_t *r =
+		&request_ring[e->full_sequence & (REQUEST_RING_SIZE - 1)];
+
+	if (r->sequence != e->full_sequence) {
+		_LOG_(ERROR,
+			  "untracked request %u failed: error code %d, major %d",
+			  e->full_sequence,
+			  e->error_code,
+			  e->major_code);
+		return;
+	}
+
+	/* BadWindow on a client means it is already gone; the destroy or
+	 * unmap notify that follows takes care of the cleanup */
+	if (e->error_code == XCB_WINDOW) {
+#ifdef _DEBUG__
+		_LOG_(DEBUG,
+			  "%s on dead window %d ignored",
+			  x_op_name(r->op),
+			  r->window);
+#endif
+		return;
+	}
+
+	_LOG_(ERROR,
+		  "%s failed for window %d: error code %d",
+		  x_op_name(r->op),
+		  r->window,
+		  e->error_code);
+}
+
 // caller must free
 static char *
 win_name(xcb_window_t win)
@@ -231,18 +339,15 @@ win_name(xcb_window_t win)
 int
 layout_handler(arg_t *arg)
 {
-	int i = get_focused_desktop_idx();
-	if (i == -1) {
-		_LOG_(ERROR, "Cannot get focused desktop");
-		return -1;
-	}
+	uint32_t i = get_focused_desktop_idx();
 
 	desktop_t *d = cur_monitor->desktops[i];
 
 	if (arg->t == STACK && d->n_count < 2)
 		return 0;
 	apply_layout(d, arg->t);
-	return render_tree(d->tree);
+	schedule_render(d);
+	return 0;
 }
 
 static xcb_ewmh_connection_t *
@@ -273,6 +378,39 @@ ewmh_init(xcb_conn_t *conn)
 	return ewmh;
 }
 
+static bool
+intern_atoms(xcb_conn_t *conn)
+{
+	static const char *names[ATOM_MAX] = {
+		[ATOM_WM_STATE]			= "WM_STATE",
+		[ATOM_WM_DELETE_WINDOW] = "WM_DELETE_WINDOW",
+	};
+	xcb_intern_atom_cookie_t cookies[ATOM_MAX];
+	bool					 ok = true;
+
+	/* send every request before waiting on the first reply, so the whole
+	 * table costs a single round trip */
+	for (int i = 0; i < ATOM_MAX; i++) {
+		cookies[i] =
+			xcb_intern_atom(conn, 0, (uint16_t)strlen(names[i]), names[i]);
+	}
+
+	for (int i = 0; i < ATOM_MAX; i++) {
+		xcb_intern_atom_reply_t *rep =
+			xcb_intern_atom_reply(conn, cookies[i], NULL);
+		if (rep == NULL) {
+			_LOG_(ERROR, "Cannot intern atom %s", names[i]);
+			atom_table[i] = XCB_NONE;
+			ok			  = false;
+			continue;
+		}
+		atom_table[i] = rep->atom;
+		free(rep);
+	}
+
+	return ok;
+}
+
 static int
 ewmh_set_supporting(xcb_window_t win, xcb_ewmh_connection_t *ewmh)
 {
@@ -306,34 +444,26 @@ ewmh_set_supporting(xcb_window_t win, xcb_ewmh_connection_t *ewmh)
 	return 0;
 }
 
-int
+uint32_t
 get_focused_desktop_idx(void)
 {
-	if (cur_monitor == NULL) {
-		_LOG_(ERROR, "cur_monitor is null\n");
-		return -1;
-	}
-	for (int i = cur_monitor->n_of_desktops; i--;) {
-		if (cur_monitor->desktops[i]->is_focused) {
-			return cur_monitor->desktops[i]->id;
-		}
-	}
-	_LOG_(ERROR, "cannot find curr monitor focused desktop\n");
-	return -1;
+	return cur_monitor->focused_desktop_idx;
 }
 
 static desktop_t *
 get_focused_desktop(void)
 {
 	monitor_t *focused_monitor = get_focused_monitor();
-	for (int i = focused_monitor->n_of_desktops; i--;) {
-		if (focused_monitor->desktops[i] != NULL &&
-			focused_monitor->desktops[i]->is_focused) {
-			return focused_monitor->desktops[i];
-		}
-	}
+	return focused_monitor ? focused_monitor->focused_desktop : NULL;
+}
 
-	return NULL;
+static void
+set_focused_desktop(monitor_t *m, uint32_t idx)
+{
+	m->desktops[m->focused_desktop_idx]->is_focused = false;
+	m->desktops[idx]->is_focused					= true;
+	m->focused_desktop_idx							= idx;
+	m->focused_desktop								= m->desktops[idx];
 }
 
 static int
@@ -358,28 +488,33 @@ ewmh_set_number_of_desktops(xcb_ewmh_connection_t *ewmh,
 static int
 ewmh_update_desktop_names(void)
 {
-	char		 names[MAXLEN];
-	uint32_t	 names_len = 0;
-	unsigned int offset	   = 0;
-	memset(names, 0, sizeof(names));
-
-	for (int n = 0; n < prim_monitor->n_of_desktops; n++) {
-		// for (int i = 0; i < wm->monitors[n]->n_of_desktops; i++) {
-		desktop_t *d = prim_monitor->desktops[n];
-		for (int j = 0; d->name[j] != '\0' && (offset + j) < sizeof(names);
-			 j++) {
-			names[offset + j] = d->name[j];
-		}
-		offset += strlen(d->name);
-		if (offset < sizeof(names)) {
-			names[offset++] = '\0';
-		}
-		// }
+	/* every name is sent NUL terminated, so the buffer is sized from
+	 * the names rather than capped at a fixed length */
+	size_t size = 0;
+	for (uint32_t n = 0; n < prim_monitor->n_of_desktops; n++) {
+		size += strlen(prim_monitor->desktops[n]->name) + 1;
+	}
+	if (size == 0) {
+		return 0;
+	}
+
+	char *names = (char *)malloc(size);
+	if (names == NULL) {
+		return -1;
+	}
+
+	size_t offset = 0;
+	for (uint32_t n = 0; n < prim_monitor->n_of_desktops; n++) {
+		const desktop_t *d	 = prim_monitor->desktops[n];
+		const size_t	 len = strlen(d->name) + 1;
+		memcpy(names + offset, d->name, len);
+		offset += len;
 	}
 
-	names_len			= offset - 1;
-	xcb_void_cookie_t c = xcb_ewmh_set_desktop_names_checked(
+	const uint32_t	  names_len = (uint32_t)(offset - 1);
+	xcb_void_cookie_t c			= xcb_ewmh_set_desktop_names_checked(
 		wm->ewmh, wm->screen_nbr, names_len, names);
+	free(names);
 	xcb_generic_error_t *err = xcb_request_check(wm->ewmh->connection, c);
 	if (err) {
 		_LOG_(ERROR,
@@ -491,15 +626,8 @@ window_above(xcb_window_t win1, xcb_window_t win2)
 		XCB_CONFIG_WINDOW_SIBLING | XCB_CONFIG_WINDOW_STACK_MODE;
 	uint32_t		  values[] = {win2, XCB_STACK_MODE_ABOVE};
 	xcb_void_cookie_t cookie =
-		xcb_configure_window_checked(wm->connection, win1, mask, values);
-	xcb_generic_error_t *err = xcb_request_check(wm->connection, cookie);
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "in stacking window %d: error code %d",
-			  win2,
-			  err->error_code);
-		free(err);
-	}
+		xcb_configure_window(wm->connection, win1, mask, values);
+	track_request(cookie, win1, OP_RESTACK);
 }
 
 // Stack win1 below win2
@@ -513,15 +641,8 @@ window_below(xcb_window_t win1, xcb_window_t win2)
 		XCB_CONFIG_WINDOW_SIBLING | XCB_CONFIG_WINDOW_STACK_MODE;
 	uint32_t		  values[] = {win2, XCB_STACK_MODE_BELOW};
 	xcb_void_cookie_t cookie =
-		xcb_configure_window_checked(wm->connection, win1, mask, values);
-	xcb_generic_error_t *err = xcb_request_check(wm->connection, cookie);
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "in stacking window %d: error code %d",
-			  win2,
-			  err->error_code);
-		free(err);
-	}
+		xcb_configure_window(wm->connection, win1, mask, values);
+	track_request(cookie, win1, OP_RESTACK);
 }
 
 void
@@ -531,15 +652,8 @@ lower_window(xcb_window_t win)
 	uint16_t		  mask	   = XCB_CONFIG_WINDOW_STACK_MODE;
 
 	xcb_void_cookie_t cookie =
-		xcb_configure_window_checked(wm->connection, win, mask, values);
-	xcb_generic_error_t *err = xcb_request_check(wm->connection, cookie);
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "in stacking window %d: error code %d",
-			  win,
-			  err->error_code);
-		free(err);
-	}
+		xcb_configure_window(wm->connection, win, mask, values);
+	track_request(cookie, win, OP_RESTACK);
 }
 
 void
@@ -549,15 +663,8 @@ raise_window(xcb_window_t win)
 	uint16_t		  mask	   = XCB_CONFIG_WINDOW_STACK_MODE;
 
 	xcb_void_cookie_t cookie =
-		xcb_configure_window_checked(wm->connection, win, mask, values);
-	xcb_generic_error_t *err = xcb_request_check(wm->connection, cookie);
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "in stacking window %d: error code %d",
-			  win,
-			  err->error_code);
-		free(err);
-	}
+		xcb_configure_window(wm->connection, win, mask, values);
+	track_request(cookie, win, OP_RESTACK);
 }
 
 int
@@ -567,11 +674,7 @@ swap_node_wrapper()
 		_LOG_(ERROR, "Failed to swap node, current monitor is NULL");
 		return -1;
 	}
-	int idx = get_focused_desktop_idx();
-	if (idx == -1) {
-		_LOG_(ERROR, "Failed to swap node, cannot find focused desktop");
-		return -1;
-	}
+	uint32_t idx = get_focused_desktop_idx();
 	node_t *root = cur_monitor->desktops[idx]->tree;
 	if (root == NULL)
 		return -1;
@@ -585,20 +688,16 @@ swap_node_wrapper()
 	if (n == NULL)
 		return -1;
 
-	if (swap_node(n) != 0)
+	if (swap_node(n, cur_monitor->desktops[idx]) != 0)
 		return -1;
 
-	return render_tree(root);
+	return 0;
 }
 
 int
 set_fullscreen_wrapper()
 {
-	const int i = get_focused_desktop_idx();
-	if (i == -1) {
-		_LOG_(ERROR, "Failed to swap node, cannot find focused desktop");
-		return -1;
-	}
+	const uint32_t i = get_focused_desktop_idx();
 
 	node_t *root = cur_monitor->desktops[i]->tree;
 	if (root == NULL)
@@ -638,34 +737,26 @@ set_fullscreen(node_t *n, bool flag)
 							   false) != 0) {
 			return -1;
 		}
-		if (resize_window(n->client->window, r.width, r.height) != 0 ||
-			move_window(n->client->window, r.x, r.y) != 0) {
-			return -1;
-		}
-		xcb_void_cookie_t c =
-			xcb_change_property_checked(wm->connection,
-										XCB_PROP_MODE_REPLACE,
-										n->client->window,
-										wm->ewmh->_NET_WM_STATE,
-										XCB_ATOM_ATOM,
-										32,
-										true,
-										data);
-		xcb_generic_error_t *err = xcb_request_check(wm->connection, c);
-		if (err) {
-			_LOG_(ERROR,
-				  "Error changing window property: %d\n",
-				  err->error_code);
-			free(err);
+		if (move_resize_window(n->client->window, r) != 0) {
 			return -1;
 		}
+		n->client->applied		= r;
+		n->client->border_width = 0;
+		n->client->border_color = NORMAL_BORDER_COLOR;
+		xcb_void_cookie_t c = xcb_change_property(wm->connection,
+												  XCB_PROP_MODE_REPLACE,
+												  n->client->window,
+												  wm->ewmh->_NET_WM_STATE,
+												  XCB_ATOM_ATOM,
+												  32,
+												  true,
+												  data);
+		track_request(c, n->client->window, OP_CHANGE_PROPERTY);
 		goto out;
 	}
 
-	r				 = n->rectangle;
 	n->client->state = TILED;
-	if (resize_window(n->client->window, r.width, r.height) != 0 ||
-		move_window(n->client->window, r.x, r.y) != 0) {
+	if (tile(n) != 0) {
 		return -1;
 	}
 	remove_property(wm->connection,
@@ -682,129 +773,28 @@ set_fullscreen(node_t *n, bool flag)
 	// free(err); 	return -1;
 	// }
 out:
-	xcb_flush(wm->connection);
 	return 0;
 }
 
 static int
-change_colors(node_t *root)
+change_colors(desktop_t *d)
 {
-	if (root == NULL)
-		return 0;
-
-	if (root->node_type != INTERNAL_NODE && root->client != NULL) {
-		if (win_focus(root->client->window, root->is_focused) != 0) {
+	for (node_t *n = d->first_leaf; n != NULL; n = n->next_leaf) {
+		if (win_focus(n->client, n->is_focused) != 0) {
 			return -1;
 		}
 	}
 
-	if (root->first_child != NULL)
-		change_colors(root->first_child);
-	if (root->second_child != NULL)
-		change_colors(root->second_child);
-
 	return 0;
 }
 
 static void
 apply_monitor_layout_changes(monitor_t *m)
 {
-	for (int d = 0; d < m->n_of_desktops; ++d) {
-		if (m->desktops[d] != NULL) {
-			if (!is_tree_empty(m->desktops[d]->tree)) {
-				layout_t l	  = m->desktops[d]->layout;
-				node_t	*tree = m->desktops[d]->tree;
-				if (l == DEFAULT) {
-					rectangle_t	   r = {0};
-					uint16_t	   w = m->rectangle.width;
-					uint16_t	   h = m->rectangle.height;
-					const uint16_t x = m->rectangle.x;
-					const uint16_t y = m->rectangle.y;
-					if (wm->bar != NULL && m == prim_monitor) {
-						r.x = x + conf.window_gap;
-						r.y = y + wm->bar->rectangle.height +
-							  conf.window_gap;
-						r.width = w - 2 * conf.window_gap -
-								  2 * conf.border_width;
-						r.height = h - wm->bar->rectangle.height -
-								   2 * conf.window_gap -
-								   2 * conf.border_width;
-					} else {
-						r.x		= x + conf.window_gap;
-						r.y		= y + conf.window_gap;
-						r.width = w - 2 * conf.window_gap -
-								  2 * conf.border_width;
-						r.height = h - 2 * conf.window_gap -
-								   2 * conf.border_width;
-					}
-					tree->rectangle = r;
-					apply_default_layout(tree);
-				} else if (l == MASTER) {
-					node_t		  *ms			= find_master_node(tree);
-					const double   ratio		= 0.70;
-					uint16_t	   w			= m->rectangle.width;
-					uint16_t	   h			= m->rectangle.height;
-					const uint16_t x			= m->rectangle.x;
-					const uint16_t y			= m->rectangle.y;
-					uint16_t	   master_width = w * ratio;
-					uint16_t	   r_width = (uint16_t)(w * (1 - ratio));
-					if (ms == NULL) {
-						ms = find_left_leaf(tree);
-						if (ms == NULL) {
-							return;
-						}
-					}
-					ms->is_master = true;
-					uint16_t bar_height =
-						wm->bar == NULL ? 0 : wm->bar->rectangle.height;
-					rectangle_t r1 = {
-						.x = x + conf.window_gap,
-						.y = (int16_t)(y + bar_height + conf.window_gap),
-						.width =
-							(uint16_t)(master_width - 2 * conf.window_gap),
-						.height = (uint16_t)(h - 2 * conf.window_gap -
-											 bar_height),
-					};
-					rectangle_t r2 = {
-						.x = (x + master_width),
-						.y = (int16_t)(y + bar_height + conf.window_gap),
-						.width =
-							(uint16_t)(r_width - (1 * conf.window_gap)),
-						.height = (uint16_t)(h - 2 * conf.window_gap -
-											 bar_height),
-					};
-					ms->rectangle	= r1;
-					tree->rectangle = r2;
-					apply_master_layout(tree);
-				} else if (l == STACK) {
-					rectangle_t	   r = {0};
-					uint16_t	   w = m->rectangle.width;
-					uint16_t	   h = m->rectangle.height;
-					const uint16_t x = m->rectangle.x;
-					const uint16_t y = m->rectangle.y;
-					if (wm->bar != NULL && m == prim_monitor) {
-						r.x = x + conf.window_gap;
-						r.y = y + wm->bar->rectangle.height +
-							  conf.window_gap;
-						r.width = w - 2 * conf.window_gap -
-								  2 * conf.border_width;
-						r.height = h - wm->bar->rectangle.height -
-								   2 * conf.window_gap -
-								   2 * conf.border_width;
-					} else {
-						r.x		= x + conf.window_gap;
-						r.y		= y + conf.window_gap;
-						r.width = w - 2 * conf.window_gap -
-								  2 * conf.border_width;
-						r.height = h - 2 * conf.window_gap -
-								   2 * conf.border_width;
-					}
-					tree->rectangle = r;
-					apply_stack_layout(tree);
-				} else if (l == GRID) {
-					// todo
-				}
-			}
+	for (uint32_t d = 0; d < m->n_of_desktops; ++d) {
+		if (m->desktops[d] != NULL &&
+			!is_tree_empty(m->desktops[d]->tree)) {
+			arrange_tree(m->desktops[d]);
 		}
 	}
 }
@@ -854,10 +844,10 @@ reload_config_wrapper()
 	if (color_changed) {
 		monitor_t *current_monitor = head_monitor;
 		while (current_monitor != NULL) {
-			for (int j = 0; j < current_monitor->n_of_desktops; j++) {
+			for (uint32_t j = 0; j < current_monitor->n_of_desktops; j++) {
 				if (!is_tree_empty(current_monitor->desktops[j]->tree)) {
-					if (change_colors(
-							current_monitor->desktops[j]->tree) != 0) {
+					if (change_colors(current_monitor->desktops[j]) !=
+						0) {
 						_LOG_(ERROR,
 							  "error while reloading config for "
 							  "desktop %d",
@@ -891,7 +881,7 @@ reload_config_wrapper()
 					goto out;
 				}
 				current_monitor->desktops = n;
-				for (int j = prev_virtual_desktops;
+				for (uint32_t j = (uint32_t)prev_virtual_desktops;
 					 j < current_monitor->n_of_desktops;
 					 j++) {
 					desktop_t *d = init_desktop();
@@ -899,7 +889,8 @@ reload_config_wrapper()
 						_LOG_(ERROR, "failed to initialize new desktop");
 						goto out;
 					}
-					d->id		  = (uint8_t)j;
+					d->monitor	  = current_monitor;
+					d->id		  = (uint32_t)j;
 					d->is_focused = false;
 					d->layout	  = DEFAULT;
 					snprintf(d->name, sizeof(d->name), "%d", j + 1);
@@ -908,21 +899,25 @@ reload_config_wrapper()
 				current_monitor = current_monitor->next;
 			}
 		} else if (conf.virtual_desktops < prev_virtual_desktops) {
-			int		   idx			   = get_focused_desktop_idx();
-			monitor_t *current_monitor = head_monitor;
+			const uint32_t last			   = conf.virtual_desktops - 1;
+			monitor_t	  *current_monitor = head_monitor;
 			while (current_monitor != NULL) {
+				if (current_monitor->focused_desktop_idx > last) {
+					if (current_monitor == cur_monitor) {
+						switch_desktop_wrapper(&(arg_t){.idx = last});
+					} else if (switch_monitor_desktop(current_monitor,
+													  last) != 0) {
+						_LOG_(ERROR,
+							  "cannot switch monitor %s to desktop %d",
+							  current_monitor->name,
+							  last + 1);
+					}
+				}
 				for (int j = conf.virtual_desktops;
 					 j < prev_virtual_desktops;
 					 j++) {
-					if (idx == current_monitor->desktops[j]->id) {
-						switch_desktop_wrapper(&(arg_t){.idx = idx--});
-					}
 					if (current_monitor->desktops[j] != NULL) {
-						if (!is_tree_empty(
-								current_monitor->desktops[j]->tree)) {
-							free_tree(current_monitor->desktops[j]->tree);
-							current_monitor->desktops[j]->tree = NULL;
-						}
+						free_tree(current_monitor->desktops[j]);
 						free(current_monitor->desktops[j]);
 						current_monitor->desktops[j] = NULL;
 					}
@@ -948,13 +943,10 @@ reload_config_wrapper()
 			return false;
 		}
 
-		const int di = get_focused_desktop_idx();
-		if (di == -1) {
-			return false;
-		}
+		const uint32_t di = get_focused_desktop_idx();
 
 		if (ewmh_update_current_desktop(
-				wm->ewmh, wm->screen_nbr, (uint32_t)di) != 0) {
+				wm->ewmh, wm->screen_nbr, di) != 0) {
 			return false;
 		}
 
@@ -970,8 +962,7 @@ reload_config_wrapper()
 
 out:
 
-	render_tree(cur_monitor->desktops[get_focused_desktop_idx()]->tree);
-	xcb_flush(wm->connection);
+	schedule_render(cur_monitor->focused_desktop);
 
 	return 0;
 }
@@ -986,21 +977,25 @@ flip_node_wrapper()
 		return 0;
 
 	node_t *node = find_node_by_window_id(
-		cur_monitor->desktops[get_focused_desktop_idx()]->tree, w);
+		cur_monitor->focused_desktop->tree, w);
 	if (node == NULL)
 		return -1;
 
-	flip_node(node);
-	return render_tree(
-		cur_monitor->desktops[get_focused_desktop_idx()]->tree);
+	/* a dynamic split is flipped from the shape it has on screen */
+	if (render_changes(cur_monitor->focused_desktop) != 0)
+		return -1;
+
+	flip_node(node, cur_monitor->focused_desktop);
+	return 0;
 }
 
 int
 cycle_win_wrapper(arg_t *arg)
 {
-	direction_t d = arg->d;
-	node_t *root  = cur_monitor->desktops[get_focused_desktop_idx()]->tree;
-	node_t *f	  = get_focused_node(root);
+	direction_t d	 = arg->d;
+	desktop_t  *dsk	 = cur_monitor->focused_desktop;
+	node_t	   *root = dsk->tree;
+	node_t	   *f	 = dsk->focused_node;
 
 	if (root == NULL) {
 		return 0;
@@ -1012,7 +1007,11 @@ cycle_win_wrapper(arg_t *arg)
 			get_window_under_cursor(wm->connection, wm->root_window);
 		f = find_node_by_window_id(root, w);
 	}
-	node_t *next = cycle_win(f, d);
+	/* neighbours are found by the rectangles windows have on screen */
+	if (render_changes(dsk) != 0) {
+		return -1;
+	}
+	node_t *next = cycle_win(dsk, f, d);
 	if (next == NULL) {
 		return 0;
 	}
@@ -1023,7 +1022,7 @@ cycle_win_wrapper(arg_t *arg)
 #endif
 	set_focus(next, true);
 	set_active_window_name(next->client->window);
-	update_focus(root, next);
+	update_focus(dsk, next);
 
 	return 0;
 }
@@ -1038,9 +1037,7 @@ traverse_stack_wrapper(arg_t *arg)
 	if (w == wm->root_window)
 		return 0;
 
-	int i = get_focused_desktop_idx();
-	if (i == -1)
-		return i;
+	uint32_t i = get_focused_desktop_idx();
 
 	node_t *root = cur_monitor->desktops[i]->tree;
 	node_t *node = find_node_by_window_id(root, w);
@@ -1051,6 +1048,7 @@ traverse_stack_wrapper(arg_t *arg)
 	}
 
 	set_focus(n, true);
+	update_focus(cur_monitor->desktops[i], n);
 	cur_monitor->desktops[i]->top_w = n->client->window;
 	return 0;
 }
@@ -1066,18 +1064,16 @@ get_active_clients_size(desktop_t **d, const int n)
 }
 
 static void
-populate_client_array(node_t *root, xcb_window_t *arr, size_t *index)
+populate_client_array(const desktop_t *d,
+					  xcb_window_t	  *arr,
+					  size_t		  *index)
 {
-	if (root == NULL)
-		return;
-
-	if (root->client != NULL && root->client->window != XCB_NONE) {
-		arr[*index] = root->client->window;
-		(*index)++;
+	for (node_t *n = d->first_leaf; n != NULL; n = n->next_leaf) {
+		if (n->client->window != XCB_NONE) {
+			arr[*index] = n->client->window;
+			(*index)++;
+		}
 	}
-
-	populate_client_array(root->first_child, arr, index);
-	populate_client_array(root->second_child, arr, index);
 }
 
 static void
@@ -1096,9 +1092,9 @@ ewmh_update_client_list(void)
 		return;
 	}
 	size_t index = 0;
-	for (int i = 0; i < prim_monitor->n_of_desktops; ++i) {
-		node_t *root = prim_monitor->desktops[i]->tree;
-		populate_client_array(root, active_clients, &index);
+	for (uint32_t i = 0; i < prim_monitor->n_of_desktops; ++i) {
+		populate_client_array(
+			prim_monitor->desktops[i], active_clients, &index);
 	}
 	xcb_ewmh_set_client_list(
 		wm->ewmh, wm->screen_nbr, size, active_clients);
@@ -1112,15 +1108,8 @@ ewmh_update_current_desktop(xcb_ewmh_connection_t *ewmh,
 							uint32_t			   i)
 {
 	xcb_void_cookie_t c =
-		xcb_ewmh_set_current_desktop_checked(ewmh, screen_nbr, i);
-	xcb_generic_error_t *err = xcb_request_check(ewmh->connection, c);
-	if (err) {
-		_LOG_(ERROR,
-			  "Error setting number of desktops: %d\n",
-			  err->error_code);
-		free(err);
-		return -1;
-	}
+		xcb_ewmh_set_current_desktop(ewmh, screen_nbr, i);
+	track_request(c, wm->root_window, OP_CHANGE_PROPERTY);
 	return 0;
 }
 
@@ -1149,30 +1138,28 @@ get_geometry(xcb_window_t win, xcb_conn_t *conn)
 }
 
 static client_t *
-create_client(xcb_window_t win, xcb_atom_t wtype, xcb_conn_t *conn)
+create_client(xcb_window_t		   win,
+			  xcb_atom_t		   wtype,
+			  const win_class_t *props,
+			  desktop_t		  *d,
+			  xcb_conn_t		  *conn)
 {
-	client_t *c = (client_t *)malloc(sizeof(client_t));
+	client_t *c = (client_t *)pool_alloc(&d->client_pool);
 	if (c == 0x00)
 		return NULL;
 
 	c->window				   = win;
 	c->type					   = wtype;
 	c->border_width			   = (uint32_t)-1;
+	c->applied				   = (rectangle_t){0};
+	c->is_mapped			   = false;
+	c->wm_state				   = XCB_ICCCM_WM_STATE_WITHDRAWN;
+	c->props				   = *props;
 	const uint32_t	  mask	   = XCB_CW_EVENT_MASK;
 	const uint32_t	  values[] = {CLIENT_EVENT_MASK};
-	xcb_void_cookie_t cookie   = xcb_change_window_attributes_checked(
-		  conn, c->window, mask, values);
-	xcb_generic_error_t *err = xcb_request_check(conn, cookie);
-
-	if (err) {
-		_LOG_(ERROR,
-			  "Error setting window attributes for client %u: %d\n",
-			  c->window,
-			  err->error_code);
-		free(err);
-		free(c);
-		exit(EXIT_FAILURE);
-	}
+	xcb_void_cookie_t cookie =
+		xcb_change_window_attributes(conn, c->window, mask, values);
+	track_request(cookie, c->window, OP_CHANGE_ATTRIBUTES);
 
 	if (change_border_attr(wm->connection,
 						   win,
@@ -1180,10 +1167,12 @@ create_client(xcb_window_t win, xcb_atom_t wtype, xcb_conn_t *conn)
 						   conf.border_width,
 						   false) != 0) {
 		_LOG_(ERROR, "Failed to change border attr for window %d\n", win);
-		free(c);
+		pool_release(&d->client_pool, c);
 		c = NULL;
 		return NULL;
 	}
+	c->border_width = conf.border_width;
+	c->border_color = conf.normal_border_color;
 
 	return c;
 }
@@ -1195,11 +1184,22 @@ init_desktop(void)
 	if (d == 0x00)
 		return NULL;
 
+	pool_init(&d->node_pool, sizeof(node_t));
+	pool_init(&d->client_pool, sizeof(client_t));
+	d->spatial	  = (spatial_t){0};
+	d->laid_out	  = (layout_key_t){0};
+	d->generation = 0;
 	d->id		  = 0;
 	d->is_focused = false;
+	d->is_dirty	  = false;
 	d->n_count	  = 0;
-	d->tree		  = NULL;
-	d->top_w	  = XCB_NONE;
+	d->tree			= NULL;
+	d->monitor		= NULL;
+	d->focused_node = NULL;
+	d->master_node	= NULL;
+	d->first_leaf	= NULL;
+	d->last_leaf	= NULL;
+	d->top_w		= XCB_NONE;
 	return d;
 }
 
@@ -1226,6 +1226,7 @@ init_monitor(void)
 static void
 add_monitor(monitor_t **head, monitor_t *m)
 {
+	monitor_table_add(m);
 	if (*head == NULL) {
 		*head = m;
 		return;
@@ -1306,25 +1307,18 @@ init_wm(void)
 static monitor_t *
 get_monitor_by_randr_id(xcb_randr_output_t id)
 {
-	monitor_t *current = head_monitor;
-	while (current != NULL) {
-		if (current->randr_id == id) {
-			return current;
-		}
-		current = current->next;
-	}
-	return NULL;
+	return monitor_by_randr_id(id);
 }
 
+/* every output shares the root window, so this stays a scan */
 static monitor_t *
 get_monitor_by_root_id(xcb_window_t id)
 {
-	monitor_t *current = head_monitor;
-	while (current != NULL) {
-		if (current->root == id) {
-			return current;
+	for (uint32_t i = 0; i < monitor_table_len(); i++) {
+		monitor_t *m = monitor_table_at(i);
+		if (m->root == id) {
+			return m;
 		}
-		current = current->next;
 	}
 	return NULL;
 }
@@ -1332,35 +1326,18 @@ get_monitor_by_root_id(xcb_window_t id)
 static monitor_t *
 get_focused_monitor()
 {
-	xcb_query_pointer_cookie_t pointer_cookie =
-		xcb_query_pointer(wm->connection, wm->root_window);
-	xcb_query_pointer_reply_t *pointer_reply =
-		xcb_query_pointer_reply(wm->connection, pointer_cookie, NULL);
-
-	if (pointer_reply == NULL) {
+	/* over a client, its enter and leave events keep the cached position
+	 * on the right monitor; nothing reports motion over the root, so
+	 * there the server is asked */
+	if (pointer.window == XCB_NONE || pointer.window == wm->root_window) {
+		invalidate_pointer();
+	}
+	if (!refresh_pointer(wm->connection)) {
 		_LOG_(ERROR, "Failed to query pointer");
 		return NULL;
 	}
 
-	int		   pointer_x = pointer_reply->root_x;
-	int		   pointer_y = pointer_reply->root_y;
-
-	monitor_t *current	 = head_monitor;
-	while (current != NULL) {
-		if (pointer_x >= current->rectangle.x &&
-			pointer_x <
-				(current->rectangle.x + current->rectangle.width) &&
-			pointer_y >= current->rectangle.y &&
-			pointer_y <
-				(current->rectangle.y + current->rectangle.height)) {
-			free(pointer_reply);
-			return current;
-		}
-		current = current->next;
-	}
-
-	free(pointer_reply);
-	return NULL;
+	return monitor_at(pointer.root_x, pointer.root_y);
 }
 
 static int
@@ -1570,11 +1547,9 @@ free_monitors(void)
 	monitor_t *current = head_monitor;
 	while (current != NULL) {
 		monitor_t *next = current->next;
-		for (int j = 0; j < current->n_of_desktops; j++) {
+		for (uint32_t j = 0; j < current->n_of_desktops; j++) {
 			if (current->desktops[j] != NULL) {
-				if (current->desktops[j]->tree != NULL) {
-					free_tree(current->desktops[j]->tree);
-				}
+				free_tree(current->desktops[j]);
 				free(current->desktops[j]);
 			}
 		}
@@ -1583,6 +1558,7 @@ free_monitors(void)
 		current = next;
 	}
 	head_monitor = NULL;
+	monitor_table_clear();
 }
 
 static void
@@ -1600,11 +1576,15 @@ ewmh_update_desktop_viewport(void)
 		return;
 	}
 
-	xcb_ewmh_coordinates_t coords[desktops_count];
-	uint16_t			   desktop = 0;
-	current_monitor				   = head_monitor;
+	xcb_ewmh_coordinates_t *coords = (xcb_ewmh_coordinates_t *)malloc(
+		desktops_count * sizeof(xcb_ewmh_coordinates_t));
+	if (coords == NULL) {
+		return;
+	}
+	uint32_t desktop = 0;
+	current_monitor	 = head_monitor;
 	while (current_monitor != NULL) {
-		for (int j = 0; j < current_monitor->n_of_desktops; j++) {
+		for (uint32_t j = 0; j < current_monitor->n_of_desktops; j++) {
 			coords[desktop++] =
 				(xcb_ewmh_coordinates_t){current_monitor->rectangle.x,
 										 current_monitor->rectangle.y};
@@ -1614,6 +1594,7 @@ ewmh_update_desktop_viewport(void)
 
 	xcb_ewmh_set_desktop_viewport(
 		wm->ewmh, wm->screen_nbr, desktop, coords);
+	free(coords);
 }
 
 static bool
@@ -1779,16 +1760,28 @@ out:
 monitor_t *
 get_monitor_from_desktop(desktop_t *desktop)
 {
-	monitor_t *current_monitor = head_monitor;
-	while (current_monitor != NULL) {
-		for (int j = 0; j < current_monitor->n_of_desktops; j++) {
-			if (current_monitor->desktops[j] == desktop) {
-				return current_monitor;
-			}
-		}
-		current_monitor = current_monitor->next;
-	}
-	return NULL;
+	return desktop->monitor;
+}
+
+/* read on every arrange, so a config reload applies to the next one */
+layout_params_t
+get_layout_params(void)
+{
+	return (layout_params_t){
+		.window_gap	  = conf.window_gap,
+		.border_width = conf.border_width,
+		.master_ratio = MASTER_RATIO,
+	};
+}
+
+/* the bar only ever sits on the primary monitor */
+rectangle_t
+get_work_area(const monitor_t *m)
+{
+	const uint16_t bar_height =
+		(wm->bar != NULL && m == prim_monitor) ? wm->bar->rectangle.height
+											   : 0;
+	return layout_work_area(m->rectangle, bar_height);
 }
 
 static bool
@@ -1804,15 +1797,18 @@ setup_desktops(void)
 			return false;
 		}
 		current_monitor->desktops = desktops;
-		for (int j = 0; j < current_monitor->n_of_desktops; j++) {
+		for (uint32_t j = 0; j < current_monitor->n_of_desktops; j++) {
 			desktop_t *d  = init_desktop();
-			d->id		  = (uint8_t)j;
+			d->monitor	  = current_monitor;
+			d->id		  = (uint32_t)j;
 			d->is_focused = (j == 0);
 			d->layout	  = DEFAULT;
 			snprintf(d->name, sizeof(d->name), "%d", j + 1);
 			current_monitor->desktops[j] = d;
 		}
-		current_monitor = current_monitor->next;
+		current_monitor->focused_desktop_idx = 0;
+		current_monitor->focused_desktop	 = desktops[0];
+		current_monitor						 = current_monitor->next;
 	}
 
 	return true;
@@ -1851,6 +1847,10 @@ setup_ewmh(void)
 		return false;
 	}
 
+	if (!intern_atoms(wm->connection)) {
+		return false;
+	}
+
 	xcb_atom_t		  net_atoms[] = {wm->ewmh->_NET_SUPPORTED,
 									 wm->ewmh->_NET_SUPPORTING_WM_CHECK,
 									 wm->ewmh->_NET_DESKTOP_NAMES,
@@ -1902,13 +1902,10 @@ setup_ewmh(void)
 		return false;
 	}
 
-	const int di = get_focused_desktop_idx();
-	if (di == -1) {
-		return false;
-	}
+	const uint32_t di = get_focused_desktop_idx();
 
 	if (ewmh_update_current_desktop(
-			wm->ewmh, wm->screen_nbr, (uint32_t)di) != 0) {
+			wm->ewmh, wm->screen_nbr, di) != 0) {
 		return false;
 	}
 
@@ -1941,6 +1938,11 @@ setup_wm(void)
 		_LOG_(ERROR, "error while setting up ewmh");
 		return false;
 	}
+
+	if (!seed_registry()) {
+		_LOG_(ERROR, "error while setting up window registry");
+		return false;
+	}
 	// load_cursors();
 	// set_cursor(CURSOR_POINTER);
 	// init_pointer();
@@ -1949,55 +1951,22 @@ setup_wm(void)
 }
 
 static int
-resize_window(xcb_window_t win, uint16_t width, uint16_t height)
-{
-	if (win == 0 || win == XCB_NONE)
-		return 0;
-
-	const uint32_t	  values[] = {width, height};
-
-	xcb_void_cookie_t cookie   = xcb_configure_window_checked(
-		  wm->connection, win, XCB_RESIZE, values);
-	xcb_generic_error_t *err = xcb_request_check(wm->connection, cookie);
-
-	if (err) {
-		_LOG_(ERROR,
-			  "Error resizing window (ID %u): %d",
-			  win,
-			  err->error_code);
-		free(err);
-		return -1;
-	}
-
-	return 0;
-}
-
-static int
-move_window(xcb_window_t win, int16_t x, int16_t y)
+move_resize_window(xcb_window_t win, rectangle_t r)
 {
 	if (win == 0 || win == XCB_NONE) {
 		return 0;
 	}
 
-	const uint32_t	  values[] = {x, y};
-	xcb_void_cookie_t cookie   = xcb_configure_window_checked(
-		  wm->connection, win, XCB_MOVE, values);
-	xcb_generic_error_t *err = xcb_request_check(wm->connection, cookie);
-
-	if (err) {
-		_LOG_(ERROR,
-			  "Error moving window (ID %u): %d",
-			  win,
-			  err->error_code);
-		free(err);
-		return -1;
-	}
+	const uint32_t	  values[] = {r.x, r.y, r.width, r.height};
+	xcb_void_cookie_t cookie =
+		xcb_configure_window(wm->connection, win, XCB_MOVE_RESIZE, values);
+	track_request(cookie, win, OP_CONFIGURE);
 
 	return 0;
 }
 
 static int
-fullscreen_focus(xcb_window_t win)
+fullscreen_focus(client_t *c)
 {
 	uint32_t bpx_width = XCB_CW_BORDER_PIXEL;
 	uint32_t b_width   = XCB_CONFIG_WINDOW_BORDER_WIDTH;
@@ -2005,30 +1974,34 @@ fullscreen_focus(xcb_window_t win)
 	uint32_t bcolor	   = 0;
 	uint32_t bwidth	   = 0;
 
-	if (change_window_attr(wm->connection, win, bpx_width, &bcolor) != 0) {
+	if (change_window_attr(
+			wm->connection, c->window, bpx_width, &bcolor) != 0) {
 		_LOG_(ERROR, "cannot update win attributes");
 		return -1;
 	}
+	c->border_color = bcolor;
 
-	if (configure_window(wm->connection, win, b_width, &bwidth) != 0) {
+	if (configure_window(
+			wm->connection, c->window, b_width, &bwidth) != 0) {
 		_LOG_(ERROR, "cannot configure window");
 		return -1;
 	}
+	c->border_width = bwidth;
 
-	if (set_input_focus(wm->connection, input, win, XCB_CURRENT_TIME) !=
-		0) {
+	if (set_input_focus(
+			wm->connection, input, c->window, XCB_CURRENT_TIME) != 0) {
 		_LOG_(ERROR, "cannot set input focus");
 		return -1;
 	}
 
-	raise_window(win);
-
-	xcb_flush(wm->connection);
+	raise_window(c->window);
 	return 0;
 }
 
+/* the border colour and width last sent are cached on the client, so
+ * moving focus only costs requests for what actually changes */
 static int
-win_focus(xcb_window_t win, bool set_focus)
+win_focus(client_t *c, bool set_focus)
 {
 	uint32_t bpx_width = XCB_CW_BORDER_PIXEL;
 	uint32_t b_width   = XCB_CONFIG_WINDOW_BORDER_WIDTH;
@@ -2037,25 +2010,31 @@ win_focus(xcb_window_t win, bool set_focus)
 		set_focus ? conf.active_border_color : conf.normal_border_color;
 	uint32_t bwidth = conf.border_width;
 
-	if (change_window_attr(wm->connection, win, bpx_width, &bcolor) != 0) {
-		_LOG_(ERROR, "cannot update win attributes");
-		return -1;
+	if (c->border_color != bcolor) {
+		if (change_window_attr(
+				wm->connection, c->window, bpx_width, &bcolor) != 0) {
+			_LOG_(ERROR, "cannot update win attributes");
+			return -1;
+		}
+		c->border_color = bcolor;
 	}
 
-	if (configure_window(wm->connection, win, b_width, &bwidth) != 0) {
-		_LOG_(ERROR, "cannot configure window");
-		return -1;
+	if (c->border_width != bwidth) {
+		if (configure_window(
+				wm->connection, c->window, b_width, &bwidth) != 0) {
+			_LOG_(ERROR, "cannot configure window");
+			return -1;
+		}
+		c->border_width = bwidth;
 	}
 
 	if (set_focus) {
 		if (set_input_focus(
-				wm->connection, input, win, XCB_CURRENT_TIME) != 0) {
+				wm->connection, input, c->window, XCB_CURRENT_TIME) != 0) {
 			_LOG_(ERROR, "cannot set input focus");
 			return -1;
 		}
 	}
-
-	xcb_flush(wm->connection);
 	return 0;
 }
 
@@ -2091,8 +2070,6 @@ change_border_attr(xcb_conn_t  *conn,
 			return -1;
 		}
 	}
-
-	xcb_flush(conn);
 	return 0;
 }
 
@@ -2103,15 +2080,8 @@ change_window_attr(xcb_conn_t  *conn,
 				   const void  *val)
 {
 	xcb_void_cookie_t attr_cookie =
-		xcb_change_window_attributes_checked(conn, win, attr, val);
-	xcb_generic_error_t *err = xcb_request_check(conn, attr_cookie);
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "Failed to change window attributes: error code %d",
-			  err->error_code);
-		free(err);
-		return -1;
-	}
+		xcb_change_window_attributes(conn, win, attr, val);
+	track_request(attr_cookie, win, OP_CHANGE_ATTRIBUTES);
 	return 0;
 }
 
@@ -2122,15 +2092,8 @@ configure_window(xcb_conn_t	 *conn,
 				 const void	 *val)
 {
 	xcb_void_cookie_t config_cookie =
-		xcb_configure_window_checked(conn, win, attr, val);
-	xcb_generic_error_t *err = xcb_request_check(conn, config_cookie);
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "Failed to configure window : error code %d",
-			  err->error_code);
-		free(err);
-		return -1;
-	}
+		xcb_configure_window(conn, win, attr, val);
+	track_request(config_cookie, win, OP_CONFIGURE);
 	return 0;
 }
 
@@ -2141,15 +2104,8 @@ set_input_focus(xcb_conn_t	   *conn,
 				xcb_timestamp_t time)
 {
 	xcb_void_cookie_t focus_cookie =
-		xcb_set_input_focus_checked(conn, revert_to, win, time);
-	xcb_generic_error_t *err = xcb_request_check(conn, focus_cookie);
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "Failed to set input focus : error code %d",
-			  err->error_code);
-		free(err);
-		return -1;
-	}
+		xcb_set_input_focus(conn, revert_to, win, time);
+	track_request(focus_cookie, win, OP_SET_INPUT_FOCUS);
 	return 0;
 }
 
@@ -2160,29 +2116,35 @@ tile(node_t *node)
 		return -1;
 	}
 
-	const uint16_t width  = node->rectangle.width;
-	const uint16_t height = node->rectangle.height;
-	const int16_t  x	  = node->rectangle.x;
-	const int16_t  y	  = node->rectangle.y;
+	client_t		 *c		= node->client;
+	const rectangle_t r		= node->rectangle;
+	const bool		  moved = c->applied.x != r.x ||
+						  c->applied.y != r.y ||
+						  c->applied.width != r.width ||
+						  c->applied.height != r.height;
 
-	if (resize_window(node->client->window, width, height) != 0 ||
-		move_window(node->client->window, x, y) != 0) {
-		return -1;
+	/* geometry and border go out as one ConfigureWindow, and only when
+	 * they differ from what the server already has */
+	if (moved || c->border_width != conf.border_width) {
+		uint16_t mask	   = XCB_MOVE_RESIZE;
+		uint32_t values[5] = {r.x, r.y, r.width, r.height};
+		if (c->border_width != conf.border_width) {
+			mask |= XCB_CONFIG_WINDOW_BORDER_WIDTH;
+			values[4] = conf.border_width;
+		}
+		configure_window(wm->connection, c->window, mask, values);
+		c->applied		= r;
+		c->border_width = conf.border_width;
+		invalidate_pointer();
 	}
 
-	xcb_void_cookie_t cookie =
-		xcb_map_window_checked(wm->connection, node->client->window);
-	xcb_generic_error_t *err = xcb_request_check(wm->connection, cookie);
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "in mapping window %d: error code %d",
-			  node->client->window,
-			  err->error_code);
-		free(err);
-		return -1;
+	if (!c->is_mapped) {
+		xcb_void_cookie_t cookie =
+			xcb_map_window(wm->connection, c->window);
+		track_request(cookie, c->window, OP_MAP);
+		c->is_mapped = true;
+		invalidate_pointer();
 	}
-
-	xcb_flush(wm->connection);
 	return 0;
 }
 
@@ -2192,9 +2154,8 @@ supports_protocol(xcb_window_t win, xcb_atom_t atom, xcb_conn_t *conn)
 	xcb_get_property_cookie_t		   cookie = {0};
 	xcb_icccm_get_wm_protocols_reply_t protocols;
 	bool							   result = false;
-	xcb_atom_t WM_PROTOCOLS = get_atom("WM_PROTOCOLS", conn);
 
-	cookie = xcb_icccm_get_wm_protocols(conn, win, WM_PROTOCOLS);
+	cookie = xcb_icccm_get_wm_protocols(conn, win, wm->ewmh->WM_PROTOCOLS);
 	if (xcb_icccm_get_wm_protocols_reply(conn, cookie, &protocols, NULL) !=
 		1) {
 		return false;
@@ -2214,29 +2175,64 @@ supports_protocol(xcb_window_t win, xcb_atom_t atom, xcb_conn_t *conn)
 static int
 display_client(rectangle_t r, xcb_window_t win)
 {
-	uint16_t width	= r.width;
-	uint16_t height = r.height;
-	int16_t	 x		= r.x;
-	int16_t	 y		= r.y;
-
-	if (resize_window(win, width, height) != 0 ||
-		move_window(win, x, y) != 0) {
+	if (move_resize_window(win, r) != 0) {
 		return -1;
 	}
 
-	xcb_void_cookie_t cookie = xcb_map_window_checked(wm->connection, win);
-	xcb_generic_error_t *err = xcb_request_check(wm->connection, cookie);
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "in mapping window %d: error code %d",
-			  win,
-			  err->error_code);
-		free(err);
-		return -1;
+	xcb_void_cookie_t cookie = xcb_map_window(wm->connection, win);
+	track_request(cookie, win, OP_MAP);
+	return 0;
+}
+
+/*
+ * Enter, motion, button and key events all carry the pointer position
+ * and the window it is over, so the pointer is tracked from those
+ * instead of asking the server on every keybinding. When windows are
+ * mapped, unmapped, moved or the desktop changes, or the pointer leaves
+ * a client, the window under the pointer may no longer be the one last
+ * reported; the next lookup then falls back to a single QueryPointer.
+ */
+static void
+track_pointer(xcb_window_t event,
+			  xcb_window_t child,
+			  int16_t	   root_x,
+			  int16_t	   root_y)
+{
+	pointer.root_x	 = root_x;
+	pointer.root_y	 = root_y;
+	/* on a client the event window is the top-level itself, on the root
+	 * the top-level under the pointer is the child */
+	pointer.window	 = (event == wm->root_window) ? child : event;
+	pointer.is_stale = false;
+}
+
+static void
+invalidate_pointer(void)
+{
+	pointer.is_stale = true;
+}
+
+static bool
+refresh_pointer(xcb_conn_t *conn)
+{
+	if (!pointer.is_stale) {
+		return true;
 	}
 
-	xcb_flush(wm->connection);
-	return 0;
+	xcb_query_pointer_cookie_t p_cookie =
+		xcb_query_pointer(conn, wm->root_window);
+	xcb_query_pointer_reply_t *p_reply =
+		xcb_query_pointer_reply(conn, p_cookie, NULL);
+
+	if (p_reply == NULL) {
+		_LOG_(ERROR, "Failed to query pointer position\n");
+		return false;
+	}
+
+	track_pointer(
+		wm->root_window, p_reply->child, p_reply->root_x, p_reply->root_y);
+	free(p_reply);
+	return true;
 }
 
 static int16_t
@@ -2260,6 +2256,10 @@ get_cursor_axis(xcb_conn_t *conn, xcb_window_t win)
 xcb_window_t
 get_window_under_cursor(xcb_conn_t *conn, xcb_window_t win)
 {
+	if (win == wm->root_window && refresh_pointer(conn)) {
+		return pointer.window;
+	}
+
 	xcb_query_pointer_cookie_t p_cookie = xcb_query_pointer(conn, win);
 	xcb_query_pointer_reply_t *p_reply =
 		xcb_query_pointer_reply(conn, p_cookie, NULL);
@@ -2311,16 +2311,18 @@ window_grab_buttons(xcb_window_t win)
 {
 #define _GRAB_BUTTON_(button)                                             \
 	do {                                                                  \
-		xcb_grab_button_checked(wm->connection,                           \
-								false,                                    \
-								win,                                      \
-								XCB_EVENT_MASK_BUTTON_PRESS,              \
-								XCB_GRAB_MODE_ASYNC,                      \
-								XCB_GRAB_MODE_ASYNC,                      \
-								wm->root_window,                          \
-								XCB_NONE,                                 \
-								button,                                   \
-								XCB_MOD_MASK_ANY);                        \
+		track_request(xcb_grab_button(wm->connection,                     \
+									  false,                              \
+									  win,                                \
+									  XCB_EVENT_MASK_BUTTON_PRESS,        \
+									  XCB_GRAB_MODE_ASYNC,                \
+									  XCB_GRAB_MODE_ASYNC,                \
+									  wm->root_window,                    \
+									  XCB_NONE,                           \
+									  button,                             \
+									  XCB_MOD_MASK_ANY),                  \
+					  win,                                                \
+					  OP_GRAB_BUTTON);                                    \
 	} while (0)
 	_GRAB_BUTTON_(XCB_BUTTON_INDEX_1);
 	_GRAB_BUTTON_(XCB_BUTTON_INDEX_2);
@@ -2331,18 +2333,9 @@ window_grab_buttons(xcb_window_t win)
 static void
 window_ungrab_buttons(xcb_window_t win)
 {
-	xcb_void_cookie_t cookie = xcb_ungrab_button_checked(
+	xcb_void_cookie_t cookie = xcb_ungrab_button(
 		wm->connection, XCB_BUTTON_INDEX_ANY, win, XCB_MOD_MASK_ANY);
-
-	xcb_generic_error_t *err = xcb_request_check(wm->connection, cookie);
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "in ungrab buttons for window %d: error code %d",
-			  win,
-			  err->error_code);
-		free(err);
-		return;
-	}
+	track_request(cookie, win, OP_UNGRAB_BUTTON);
 }
 
 static void
@@ -2427,21 +2420,10 @@ grab_keys(xcb_conn_t *conn, xcb_window_t win)
 }
 
 static xcb_atom_t
-get_atom(char *atom_name, xcb_conn_t *conn)
+get_atom(atom_t a)
 {
-	xcb_intern_atom_cookie_t atom_cookie;
-	xcb_atom_t				 atom;
-	xcb_intern_atom_reply_t *rep;
-
-	atom_cookie =
-		xcb_intern_atom(conn, 0, (uint16_t)strlen(atom_name), atom_name);
-	rep = xcb_intern_atom_reply(conn, atom_cookie, NULL);
-	if (NULL != rep) {
-		atom = rep->atom;
-		free(rep);
-		return atom;
-	}
-	return 0;
+	assert(a < ATOM_MAX);
+	return atom_table[a];
 }
 
 static int
@@ -2467,8 +2449,6 @@ send_client_message(xcb_window_t win,
 		free(err);
 		return -1;
 	}
-
-	xcb_flush(conn);
 	free(e);
 	return 0;
 }
@@ -2486,24 +2466,24 @@ close_or_kill_wrapper()
 static int
 close_or_kill(xcb_window_t win)
 {
-	xcb_atom_t wm_delete = get_atom("WM_DELETE_WINDOW", wm->connection);
-	xcb_icccm_get_text_property_reply_t t_reply;
-	xcb_get_property_cookie_t			cn =
-		xcb_icccm_get_wm_name(wm->connection, win);
+	xcb_atom_t		wm_delete = get_atom(ATOM_WM_DELETE_WINDOW);
+	const client_t *c		  = find_managed_client(win);
+	bool			can_delete;
 
-	const uint8_t wr =
-		xcb_icccm_get_wm_name_reply(wm->connection, cn, &t_reply, NULL);
-	if (supports_protocol(win, wm_delete, wm->connection)) {
-		if (wr == 1) {
+	if (c != NULL) {
+		can_delete = c->props.supports_delete;
+	} else {
+		/* unmanaged windows have no cached protocols to go by */
+		can_delete = supports_protocol(win, wm_delete, wm->connection);
+	}
+
+	if (can_delete) {
 #ifdef _DEBUG__
-			_LOG_(DEBUG,
-				  "window id = %d, reply name = %s: supports "
-				  "WM_DELETE_WINDOW\n",
-				  win,
-				  t_reply.name);
+		_LOG_(DEBUG,
+			  "window id = %d, name = %s: supports WM_DELETE_WINDOW\n",
+			  win,
+			  c != NULL ? c->props.name : NULL_STR);
 #endif
-			xcb_icccm_get_text_property_reply_wipe(&t_reply);
-		}
 		int ret = send_client_message(
 			win, wm->ewmh->WM_PROTOCOLS, wm_delete, wm->connection);
 		if (ret != 0) {
@@ -2513,16 +2493,8 @@ close_or_kill(xcb_window_t win)
 		return 0;
 	}
 
-	xcb_void_cookie_t	 c = xcb_kill_client_checked(wm->connection, win);
-	xcb_generic_error_t *err = xcb_request_check(wm->connection, c);
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "error closing window: %d, error: %d\n",
-			  win,
-			  err->error_code);
-		free(err);
-		return -1;
-	}
+	xcb_void_cookie_t kc = xcb_kill_client(wm->connection, win);
+	track_request(kc, win, OP_KILL_CLIENT);
 	return 0;
 }
 
@@ -2558,8 +2530,7 @@ map_floating(xcb_window_t x)
 	rc.y	  = g->y;
 
 	free(g);
-	resize_window(x, rc.width, rc.height);
-	move_window(x, rc.x, rc.y);
+	move_resize_window(x, rc);
 	xcb_map_window(wm->connection, x);
 }
 
@@ -2570,120 +2541,56 @@ kill_window(xcb_window_t win)
 		return -1;
 	}
 
-	xcb_icccm_get_text_property_reply_t t_reply;
-	xcb_get_property_cookie_t			cn =
-		xcb_icccm_get_wm_name(wm->connection, win);
-	const uint8_t wr =
-		xcb_icccm_get_wm_name_reply(wm->connection, cn, &t_reply, NULL);
-
-	if (wr == 1) {
-#ifdef _DEBUG__
-		_LOG_(DEBUG,
-			  "delete window id = %d, reply name = %s\n",
-			  win,
-			  t_reply.name);
-#endif
-		xcb_icccm_get_text_property_reply_wipe(&t_reply);
-	}
-
 	if (win == 0) {
 		return 0;
 	}
 
-	int curi = get_focused_desktop_idx();
-	if (curi == -1) {
-		_LOG_(ERROR, "cannot find focused desktop");
-		return curi;
-	}
-
-	desktop_t *d = cur_monitor->desktops[curi];
-	node_t	  *n = find_node_by_window_id(d->tree, win);
+	/* the window may live on any desktop of any monitor */
+	desktop_t *d = NULL;
+	node_t	  *n = registry_lookup(win, NULL, &d);
 	client_t  *c = (n != NULL) ? n->client : NULL;
 
 	if (c == NULL) {
 		_LOG_(ERROR, "cannot find client with window %d", win);
 		return -1;
 	}
+#ifdef _DEBUG__
+	_LOG_(DEBUG, "delete window id = %d, name = %s\n", win, c->props.name);
+#endif
 
 	xcb_void_cookie_t cookie = xcb_unmap_window(wm->connection, c->window);
-	xcb_generic_error_t *err = xcb_request_check(wm->connection, cookie);
-
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "Error in unmapping window %d: error code %d",
-			  c->window,
-			  err->error_code);
-		free(err);
-		return -1;
-	}
+	track_request(cookie, c->window, OP_UNMAP);
 
 	delete_node(n, d);
 	// ewmh_update_client_list();
 
-	if (is_tree_empty(d->tree)) {
+	if (d->is_focused && is_tree_empty(d->tree)) {
 		set_active_window_name(XCB_NONE);
 	}
 
-	if (render_tree(d->tree) != 0) {
-		_LOG_(ERROR, "cannot render tree");
-		return -1;
-	}
-
 	return 0;
 }
 
 int
-show_window(xcb_window_t win)
+show_window(client_t *c)
 {
-	xcb_generic_error_t *err;
-	xcb_void_cookie_t	 c;
 	/* According to ewmh:
 	 * Mapped windows should be placed in NormalState, according to
 	 * the ICCCM.
 	 **/
-	c	= xcb_map_window_checked(wm->connection, win);
-	err = xcb_request_check(wm->connection, c);
-
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "Cannot hide window %d: error code %d",
-			  win,
-			  err->error_code);
-		free(err);
-		return -1;
-	}
-
-	// set window property to NormalState
-	// XCB_ICCCM_WM_STATE_NORMAL
-	const long		 data[] = {XCB_ICCCM_WM_STATE_NORMAL, XCB_NONE};
-	const xcb_atom_t wm_s	= get_atom("WM_STATE", wm->connection);
-	c						= xcb_change_property_checked(wm->connection,
-									  XCB_PROP_MODE_REPLACE,
-									  win,
-									  wm_s,
-									  wm_s,
-									  32,
-									  2,
-									  data);
-	err						= xcb_request_check(wm->connection, c);
-
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "Cannot change window property %d: error code %d",
-			  win,
-			  err->error_code);
-		free(err);
-		return -1;
+	if (!c->is_mapped) {
+		xcb_void_cookie_t cookie =
+			xcb_map_window(wm->connection, c->window);
+		track_request(cookie, c->window, OP_MAP);
+		c->is_mapped = true;
 	}
 
-	return 0;
+	return set_window_state(c, XCB_ICCCM_WM_STATE_NORMAL);
 }
 
 int
-hide_window(xcb_window_t win)
+hide_window(client_t *c)
 {
-	xcb_generic_error_t *err;
-	xcb_void_cookie_t	 c;
 	/* According to ewmh:
 	 * Unmapped windows should be placed in IconicState, according to
 	 * the ICCCM. Windows which are actually iconified or minimized
@@ -2691,41 +2598,14 @@ hide_window(xcb_window_t win)
 	 * communicate to pagers that the window should not be represented
 	 * as "onscreen."
 	 **/
-	c	= xcb_unmap_window_checked(wm->connection, win);
-	err = xcb_request_check(wm->connection, c);
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "Cannot hide window %d: error code %d",
-			  win,
-			  err->error_code);
-		free(err);
-		return -1;
-	}
-
-	// set window property to IconicState
-	// XCB_ICCCM_WM_STATE_ICONIC
-	const long		 data[] = {XCB_ICCCM_WM_STATE_ICONIC, XCB_NONE};
-	const xcb_atom_t wm_s	= get_atom("WM_STATE", wm->connection);
-	c						= xcb_change_property_checked(wm->connection,
-									  XCB_PROP_MODE_REPLACE,
-									  win,
-									  wm_s,
-									  wm_s,
-									  32,
-									  2,
-									  data);
-	err						= xcb_request_check(wm->connection, c);
-
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "Cannot change window property %d: error code %d",
-			  win,
-			  err->error_code);
-		free(err);
-		return -1;
+	if (c->is_mapped) {
+		xcb_void_cookie_t cookie =
+			xcb_unmap_window(wm->connection, c->window);
+		track_request(cookie, c->window, OP_UNMAP);
+		c->is_mapped = false;
 	}
 
-	return 0;
+	return set_window_state(c, XCB_ICCCM_WM_STATE_ICONIC);
 }
 
 int
@@ -2760,26 +2640,11 @@ exec_process(arg_t *arg)
 	return 0;
 }
 
-static void
-update_focused_desktop(int id)
-{
-	if (cur_monitor == NULL) {
-		return;
-	}
-	for (int i = 0; i < cur_monitor->n_of_desktops; ++i) {
-		if (cur_monitor->desktops[i]->id != id) {
-			cur_monitor->desktops[i]->is_focused = false;
-		} else {
-			cur_monitor->desktops[i]->is_focused = true;
-		}
-	}
-}
-
 int
 set_focus(node_t *n, bool flag)
 {
 	n->is_focused = flag;
-	if (win_focus(n->client->window, flag) != 0) {
+	if (win_focus(n->client, flag) != 0) {
 		return -1;
 	}
 
@@ -2792,7 +2657,7 @@ set_focus(node_t *n, bool flag)
 int
 switch_desktop_wrapper(arg_t *arg)
 {
-	if (arg->idx > conf.virtual_desktops) {
+	if ((int)arg->idx > conf.virtual_desktops) {
 		return 0;
 	}
 
@@ -2813,70 +2678,73 @@ switch_desktop_wrapper(arg_t *arg)
 			return 0;
 		}
 		set_focus(n, true);
+		update_focus(cur_monitor->desktops[arg->idx], n);
 		return 0;
 	}
 out:
-	return render_tree(tree);
+	return 0;
 }
 
+/* shows desktop nd of m in place of the one it has focused. the root
+ * stops reporting substructure changes meanwhile, so the windows that
+ * are unmapped are not taken for windows going away */
 static int
-switch_desktop(const int nd)
+switch_monitor_desktop(monitor_t *m, uint32_t nd)
 {
-	if (nd > conf.virtual_desktops) {
-		return 0;
-	}
-
-	int current = get_focused_desktop_idx();
-	if (current == -1)
-		return current;
-	if (nd == current)
-		return 0;
-
-	update_focused_desktop(nd);
+	const uint32_t current = m->focused_desktop_idx;
+	const uint32_t _off[]  = {ROOT_EVENT_MASK &
+							  ~XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY};
+	const uint32_t _on[]   = {ROOT_EVENT_MASK};
 
-	const uint32_t		 _off[] = {ROOT_EVENT_MASK &
-								   ~XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY};
-	const uint32_t		 _on[]	= {ROOT_EVENT_MASK};
-	xcb_generic_error_t *err;
-	xcb_void_cookie_t	 c;
-
-	c = xcb_change_window_attributes_checked(
+	set_focused_desktop(m, nd);
+	change_window_attr(
 		wm->connection, wm->root_window, XCB_CW_EVENT_MASK, _off);
-	err = xcb_request_check(wm->connection, c);
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "Cannot change root window %d attrs: error code %d",
-			  wm->root_window,
-			  err->error_code);
-		free(err);
+
+	if (show_windows(m->desktops[nd]) != 0) {
 		return -1;
 	}
+	schedule_render(m->desktops[nd]);
 
-	if (show_windows(cur_monitor->desktops[nd]->tree) != 0) {
+	/* hide_windows() has already unfocused everything it hid */
+	if (hide_windows(m->desktops[current]) != 0) {
 		return -1;
 	}
+	m->desktops[current]->focused_node = NULL;
 
-	if (hide_windows(cur_monitor->desktops[current]->tree) != 0) {
-		return -1;
+	change_window_attr(
+		wm->connection, wm->root_window, XCB_CW_EVENT_MASK, _on);
+	return 0;
+}
+
+static int
+switch_desktop(const int nd)
+{
+	if (nd > conf.virtual_desktops) {
+		return 0;
 	}
 
-	set_active_window_name(XCB_NONE);
-	win_focus(focused_win, false);
-	focused_win = XCB_NONE;
+	uint32_t current = get_focused_desktop_idx();
+	if ((uint32_t)nd == current)
+		return 0;
 
-	c			= xcb_change_window_attributes_checked(
-		  wm->connection, wm->root_window, XCB_CW_EVENT_MASK, _on);
-	err = xcb_request_check(wm->connection, c);
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "Cannot change root window %d attrs: error code %d",
-			  wm->root_window,
-			  err->error_code);
-		free(err);
+	invalidate_pointer();
+	if (switch_monitor_desktop(cur_monitor, (uint32_t)nd) != 0) {
 		return -1;
 	}
 
+	set_active_window_name(XCB_NONE);
+	focused_win = XCB_NONE;
+
 #ifdef _DEBUG__
+	const desktop_t *od = cur_monitor->desktops[current];
+	_LOG_(DEBUG,
+		  "desktop %d pools: nodes %u live %u pooled, clients %u live "
+		  "%u pooled",
+		  current + 1,
+		  od->node_pool.n_live,
+		  od->node_pool.n_pooled,
+		  od->client_pool.n_live,
+		  od->client_pool.n_pooled);
 	_LOG_(INFO, "new desktop %d nodes--------------", nd + 1);
 	log_tree_nodes(cur_monitor->desktops[nd]->tree);
 	_LOG_(INFO, "old desktop %d nodes--------------", current + 1);
@@ -2887,8 +2755,6 @@ switch_desktop(const int nd)
 		return -1;
 	}
 
-	xcb_flush(wm->connection);
-
 	return 0;
 }
 
@@ -2902,7 +2768,7 @@ log_monitors(void)
 			  current_monitor->name,
 			  current_monitor->randr_id,
 			  current_monitor->root);
-		for (int j = 0; j < current_monitor->n_of_desktops; j++) {
+		for (uint32_t j = 0; j < current_monitor->n_of_desktops; j++) {
 			log_tree_nodes(current_monitor->desktops[j]->tree);
 		}
 		current_monitor = current_monitor->next;
@@ -2912,193 +2778,309 @@ log_monitors(void)
 int
 cycle_desktop_wrapper(arg_t *arg)
 {
-	int current = get_focused_desktop_idx();
-	if (current == -1) {
-		_LOG_(ERROR, "Cannot find current desktop");
-		return -1;
-	}
+	const int current = (int)get_focused_desktop_idx();
 
 	int n_desktops = cur_monitor->n_of_desktops;
 	int next =
 		(current + (arg->d == RIGHT ? 1 : -1) + n_desktops) % n_desktops;
 
-	switch_desktop(next);
-	return render_tree(cur_monitor->desktops[next]->tree);
+	return switch_desktop(next);
 }
 
 static int
 set_active_window_name(xcb_window_t win)
 {
 	xcb_void_cookie_t aw_cookie =
-		xcb_ewmh_set_active_window_checked(wm->ewmh, wm->screen_nbr, win);
-	xcb_generic_error_t *err =
-		xcb_request_check(wm->connection, aw_cookie);
-
-	if (err) {
-		_LOG_(ERROR, "Error setting active window: %d\n", err->error_code);
-		free(err);
-		return -1;
-	}
+		xcb_ewmh_set_active_window(wm->ewmh, wm->screen_nbr, win);
+	track_request(aw_cookie, wm->root_window, OP_SET_ACTIVE_WINDOW);
 
 	return 0;
 }
 
+/* WM_STATE is only written when it differs from what this client was
+ * last given, so a desktop switch does not rewrite the property of
+ * every window on both desktops */
 static int
-set_window_state(xcb_window_t win, xcb_icccm_wm_state_t state)
+set_window_state(client_t *c, xcb_icccm_wm_state_t state)
 {
+	if (c->wm_state == state)
+		return 0;
+
 	const long		  data[] = {state, XCB_NONE};
-	xcb_atom_t		  t		 = get_atom("WM_STATE", wm->connection);
-	xcb_void_cookie_t c		 = xcb_change_property_checked(
-		 wm->connection, XCB_PROP_MODE_REPLACE, win, t, t, 32, 2, data);
-	xcb_generic_error_t *err = xcb_request_check(wm->connection, c);
-	if (err != NULL) {
-		_LOG_(ERROR,
-			  "in changing property window %d: error code %d",
-			  win,
-			  err->error_code);
-		free(err);
-		return -1;
-	}
+	xcb_atom_t		  t		 = get_atom(ATOM_WM_STATE);
+	xcb_void_cookie_t k		 = xcb_change_property(wm->connection,
+												   XCB_PROP_MODE_REPLACE,
+												   c->window,
+												   t,
+												   t,
+												   32,
+												   2,
+												   data);
+	track_request(k, c->window, OP_CHANGE_PROPERTY);
+	c->wm_state = state;
 	return 0;
 }
 
-static bool
-should_manage(xcb_window_t win, xcb_conn_t *conn)
+/* maps a _NET_WM_WINDOW_TYPE reply to the codes handle_map_request
+ * switches on; -1 when the window sets no type at all */
+static int
+window_type(const xcb_ewmh_get_atoms_reply_t *w_type)
 {
-	xcb_get_window_attributes_cookie_t attr_cookie;
-	xcb_get_window_attributes_reply_t *attr_reply;
+	for (unsigned int i = 0; i < w_type->atoms_len; ++i) {
+		const xcb_atom_t a = w_type->atoms[i];
+		if (a == wm->ewmh->_NET_WM_WINDOW_TYPE_NORMAL) {
+			/*
+			 * _NET_WM_WINDOW_TYPE_NORMAL
+			 * indicates that this is a normal, top-level window.
+			 * */
+			return 1;
+		} else if (a == wm->ewmh->_NET_WM_WINDOW_TYPE_DOCK) {
+			/*
+			 * _NET_WM_WINDOW_TYPE_DOCK
+			 * indicates a dock or panel feature.
+			 * Typically, a Window Manager would keep such windows
+			 * on top of all other windows.
+			 * */
+			return 2;
+		} else if (a == wm->ewmh->_NET_WM_WINDOW_TYPE_TOOLBAR ||
+				   a == wm->ewmh->_NET_WM_WINDOW_TYPE_MENU) {
+			/*
+			 * _NET_WM_WINDOW_TYPE_TOOLBAR and
+			 * _NET_WM_WINDOW_TYPE_MENU indicate toolbar and
+			 * pinnable menu windows, respectively (i.e. toolbars
+			 * and menus "torn off" from the main application).
+			 * Windows of this type may set the WM_TRANSIENT_FOR
+			 * hint indicating the main application window.
+			 * */
+			return 3;
+		} else if (a == wm->ewmh->_NET_WM_WINDOW_TYPE_UTILITY) {
+			/*
+			 * _NET_WM_WINDOW_TYPE_UTILITY
+			 * indicates a small persistent utility window, such
+			 * as a palette or toolbox. It is distinct from type
+			 * TOOLBAR because it does not correspond to a toolbar
+			 * torn off from the main application. It's distinct
+			 * from type DIALOG because it isn't a transient
+			 * dialog, the user will probably keep it open while
+			 * they're working. Windows of this type may set the
+			 * WM_TRANSIENT_FOR hint indicating the main
+			 * application window.
+			 * */
+			return 4;
+		} else if (a == wm->ewmh->_NET_WM_WINDOW_TYPE_SPLASH) {
+			/*
+			 * _NET_WM_WINDOW_TYPE_SPLASH
+			 * indicates that the window is a splash screen
+			 * displayed as an application is starting up.
+			 * */
+			return 5;
+		} else if (a == wm->ewmh->_NET_WM_WINDOW_TYPE_DIALOG) {
+			/*
+			 * _NET_WM_WINDOW_TYPE_DIALOG
+			 * indicates that this is a dialog window.
+			 * If _NET_WM_WINDOW_TYPE is not set,
+			 * then windows with WM_TRANSIENT_FOR set MUST be
+			 * taken as this type.
+			 * */
+			return 6;
+		} else if (a == wm->ewmh->_NET_WM_WINDOW_TYPE_NOTIFICATION) {
+			/*
+			 * _NET_WM_WINDOW_TYPE_NOTIFICATION
+			 * indicates a notification. An example of a
+			 * notification would be a bubble appearing with
+			 * informative text such as "Your laptop is running
+			 * out of power" etc. This property is typically used
+			 * on override-redirect windows.
+			 * */
+			return 7;
+		} else {
+			return 1;
+		}
+	}
+	return -1;
+}
 
-	attr_cookie = xcb_get_window_attributes(conn, win);
-	attr_reply	= xcb_get_window_attributes_reply(conn, attr_cookie, NULL);
+static void
+collect_wm_name(xcb_get_property_cookie_t c, win_class_t *wc)
+{
+	xcb_icccm_get_text_property_reply_t t_reply;
+	wc->name[0] = '\0';
+	if (xcb_icccm_get_wm_name_reply(wm->connection, c, &t_reply, NULL) !=
+		1) {
+		return;
+	}
+	const size_t len = t_reply.name_len < sizeof(wc->name) - 1
+						   ? t_reply.name_len
+						   : sizeof(wc->name) - 1;
+	memcpy(wc->name, t_reply.name, len);
+	wc->name[len] = '\0';
+	xcb_icccm_get_text_property_reply_wipe(&t_reply);
+}
 
-	if (attr_reply == NULL) {
-		return true;
+static void
+collect_wm_class(xcb_get_property_cookie_t c, win_class_t *wc)
+{
+	xcb_icccm_get_wm_class_reply_t class_reply;
+	wc->class_name[0]	 = '\0';
+	wc->instance_name[0] = '\0';
+	if (xcb_icccm_get_wm_class_reply(
+			wm->connection, c, &class_reply, NULL) != 1) {
+		return;
 	}
+	if (class_reply.class_name != NULL) {
+		snprintf(wc->class_name,
+				 sizeof(wc->class_name),
+				 "%s",
+				 class_reply.class_name);
+	}
+	if (class_reply.instance_name != NULL) {
+		snprintf(wc->instance_name,
+				 sizeof(wc->instance_name),
+				 "%s",
+				 class_reply.instance_name);
+	}
+	xcb_icccm_get_wm_class_reply_wipe(&class_reply);
+}
 
-	bool manage = !attr_reply->override_redirect;
-	free(attr_reply);
-	return manage;
+static void
+collect_size_hints(xcb_get_property_cookie_t c, win_class_t *wc)
+{
+	xcb_size_hints_t hints;
+	wc->fixed_size = false;
+	if (xcb_icccm_get_wm_normal_hints_reply(
+			wm->connection, c, &hints, NULL) != 1) {
+		return;
+	}
+	/* if min-h == max-h && min-w == max-w, */
+	/* then window should be floated */
+	const uint32_t size_mask =
+		(XCB_ICCCM_SIZE_HINT_P_MIN_SIZE | XCB_ICCCM_SIZE_HINT_P_MAX_SIZE);
+	wc->fixed_size = (hints.flags & size_mask) &&
+					 hints.min_width == hints.max_width &&
+					 hints.min_height == hints.max_height;
 }
 
-static int
-apply_floating_hints(xcb_window_t win)
+/* _NET_WM_WINDOW_TYPE and WM_TRANSIENT_FOR are always collected together
+ * because the second decides the type when the first is missing */
+static void
+collect_window_type(xcb_get_property_cookie_t tc,
+					xcb_get_property_cookie_t fc,
+					win_class_t				 *wc)
 {
-	xcb_get_property_cookie_t c =
-		xcb_icccm_get_wm_normal_hints(wm->connection, win);
-	xcb_size_hints_t size_hints;
-
-	uint8_t			 r = xcb_icccm_get_wm_normal_hints_reply(
-		 wm->connection, c, &size_hints, NULL);
-	if (1 == r) {
-		/* if min-h == max-h && min-w == max-w, */
-		/* then window should be floated */
-		uint32_t size_mask = (XCB_ICCCM_SIZE_HINT_P_MIN_SIZE |
-							  XCB_ICCCM_SIZE_HINT_P_MAX_SIZE);
-		int32_t	 miw	   = size_hints.min_width;
-		int32_t	 mxw	   = size_hints.max_width;
-		int32_t	 mih	   = size_hints.min_height;
-		int32_t	 mxh	   = size_hints.max_height;
-
-		if ((size_hints.flags & size_mask) && (miw == mxw) &&
-			(mih == mxh)) {
-			// window should be floated
-			return 0;
+	xcb_ewmh_get_atoms_reply_t w_type;
+	xcb_window_t			   transient = XCB_NONE;
+
+	wc->type						 = -1;
+	wc->transient_for				 = XCB_NONE;
+	if (xcb_ewmh_get_wm_window_type_reply(wm->ewmh, tc, &w_type, NULL) ==
+		1) {
+		wc->type = window_type(&w_type);
+		xcb_ewmh_get_atoms_reply_wipe(&w_type);
+	}
+
+	if (xcb_icccm_get_wm_transient_for_reply(
+			wm->connection, fc, &transient, NULL) == 1) {
+		wc->transient_for = transient;
+	}
+
+	/* If _NET_WM_WINDOW_TYPE is not set, then windows with
+	 * WM_TRANSIENT_FOR set MUST be taken as a dialog */
+	if (wc->type == -1 && wc->transient_for != XCB_NONE) {
+		wc->type = 6;
+	}
+}
+
+static void
+collect_protocols(xcb_get_property_cookie_t c, win_class_t *wc)
+{
+	xcb_icccm_get_wm_protocols_reply_t protocols;
+	wc->supports_delete = false;
+	if (xcb_icccm_get_wm_protocols_reply(
+			wm->connection, c, &protocols, NULL) != 1) {
+		return;
+	}
+	for (uint32_t i = 0; i < protocols.atoms_len; i++) {
+		if (protocols.atoms[i] == get_atom(ATOM_WM_DELETE_WINDOW)) {
+			wc->supports_delete = true;
 		}
 	}
-	return -1;
+	xcb_icccm_get_wm_protocols_reply_wipe(&protocols);
 }
 
-static int
-window_type(xcb_window_t win)
+static void
+classify_window(xcb_window_t win, win_class_t *wc)
 {
-	xcb_ewmh_get_atoms_reply_t w_type;
-	xcb_get_property_cookie_t  c =
+	xcb_conn_t *conn = wm->connection;
+
+	memset(wc, 0, sizeof(*wc));
+
+	/* fire every request first and only then start collecting, so
+	 * classifying a window costs one round trip instead of seven */
+	xcb_get_window_attributes_cookie_t ac =
+		xcb_get_window_attributes(conn, win);
+	xcb_get_property_cookie_t nc = xcb_icccm_get_wm_name(conn, win);
+	xcb_get_property_cookie_t cc = xcb_icccm_get_wm_class(conn, win);
+	xcb_get_property_cookie_t hc =
+		xcb_icccm_get_wm_normal_hints(conn, win);
+	xcb_get_property_cookie_t tc =
 		xcb_ewmh_get_wm_window_type(wm->ewmh, win);
-	const uint8_t r =
-		xcb_ewmh_get_wm_window_type_reply(wm->ewmh, c, &w_type, NULL);
-
-	if (r == 1) {
-		for (unsigned int i = 0; i < w_type.atoms_len; ++i) {
-			const xcb_atom_t a = w_type.atoms[i];
-			if (a == wm->ewmh->_NET_WM_WINDOW_TYPE_NORMAL) {
-				/*
-				 * _NET_WM_WINDOW_TYPE_NORMAL
-				 * indicates that this is a normal, top-level window.
-				 * */
-				xcb_ewmh_get_atoms_reply_wipe(&w_type);
-				return 1;
-			} else if (a == wm->ewmh->_NET_WM_WINDOW_TYPE_DOCK) {
-				/*
-				 * _NET_WM_WINDOW_TYPE_DOCK
-				 * indicates a dock or panel feature.
-				 * Typically, a Window Manager would keep such windows
-				 * on top of all other windows.
-				 * */
-				xcb_ewmh_get_atoms_reply_wipe(&w_type);
-				return 2;
-			} else if (a == wm->ewmh->_NET_WM_WINDOW_TYPE_TOOLBAR ||
-					   a == wm->ewmh->_NET_WM_WINDOW_TYPE_MENU) {
-				/*
-				 * _NET_WM_WINDOW_TYPE_TOOLBAR and
-				 * _NET_WM_WINDOW_TYPE_MENU indicate toolbar and
-				 * pinnable menu windows, respectively (i.e. toolbars
-				 * and menus "torn off" from the main application).
-				 * Windows of this type may set the WM_TRANSIENT_FOR
-				 * hint indicating the main application window.
-				 * */
-				xcb_ewmh_get_atoms_reply_wipe(&w_type);
-				return 3;
-			} else if (a == wm->ewmh->_NET_WM_WINDOW_TYPE_UTILITY) {
-				/*
-				 * _NET_WM_WINDOW_TYPE_UTILITY
-				 * indicates a small persistent utility window, such
-				 * as a palette or toolbox. It is distinct from type
-				 * TOOLBAR because it does not correspond to a toolbar
-				 * torn off from the main application. It's distinct
-				 * from type DIALOG because it isn't a transient
-				 * dialog, the user will probably keep it open while
-				 * they're working. Windows of this type may set the
-				 * WM_TRANSIENT_FOR hint indicating the main
-				 * application window.
-				 * */
-				xcb_ewmh_get_atoms_reply_wipe(&w_type);
-				return 4;
-			} else if (a == wm->ewmh->_NET_WM_WINDOW_TYPE_SPLASH) {
-				/*
-				 * _NET_WM_WINDOW_TYPE_SPLASH
-				 * indicates that the window is a splash screen
-				 * displayed as an application is starting up.
-				 * */
-				xcb_ewmh_get_atoms_reply_wipe(&w_type);
-				return 5;
-			} else if (a == wm->ewmh->_NET_WM_WINDOW_TYPE_DIALOG) {
-				/*
-				 * _NET_WM_WINDOW_TYPE_DIALOG
-				 * indicates that this is a dialog window.
-				 * If _NET_WM_WINDOW_TYPE is not set,
-				 * then windows with WM_TRANSIENT_FOR set MUST be
-				 * taken as this type.
-				 * */
-				xcb_ewmh_get_atoms_reply_wipe(&w_type);
-				return 6;
-			} else if (a == wm->ewmh->_NET_WM_WINDOW_TYPE_NOTIFICATION) {
-				/*
-				 * _NET_WM_WINDOW_TYPE_NOTIFICATION
-				 * indicates a notification. An example of a
-				 * notification would be a bubble appearing with
-				 * informative text such as "Your laptop is running
-				 * out of power" etc. This property is typically used
-				 * on override-redirect windows.
-				 * */
-				xcb_ewmh_get_atoms_reply_wipe(&w_type);
-				return 7;
-			} else {
-				xcb_ewmh_get_atoms_reply_wipe(&w_type);
-				return 1;
-			}
-		}
+	xcb_get_property_cookie_t fc =
+		xcb_icccm_get_wm_transient_for(conn, win);
+	xcb_get_property_cookie_t pc =
+		xcb_icccm_get_wm_protocols(conn, win, wm->ewmh->WM_PROTOCOLS);
+
+	xcb_get_window_attributes_reply_t *attr =
+		xcb_get_window_attributes_reply(conn, ac, NULL);
+	if (attr != NULL) {
+		wc->override_redirect = attr->override_redirect;
+		free(attr);
+	}
+
+	collect_wm_name(nc, wc);
+	collect_wm_class(cc, wc);
+	collect_size_hints(hc, wc);
+	collect_window_type(tc, fc, wc);
+	collect_protocols(pc, wc);
+}
+
+static client_t *
+find_managed_client(xcb_window_t win)
+{
+	node_t *n = registry_lookup(win, NULL, NULL);
+	return (n != NULL) ? n->client : NULL;
+}
+
+/* the only place a managed client's cached properties are refreshed */
+static int
+handle_property_notify(const xcb_property_notify_event_t *ev)
+{
+	client_t *c = find_managed_client(ev->window);
+	if (c == NULL) {
+		return 0;
 	}
-	return -1;
+
+	xcb_conn_t	*conn = wm->connection;
+	win_class_t *wc	  = &c->props;
+	if (ev->atom == XCB_ATOM_WM_NAME) {
+		collect_wm_name(xcb_icccm_get_wm_name(conn, c->window), wc);
+	} else if (ev->atom == XCB_ATOM_WM_CLASS) {
+		collect_wm_class(xcb_icccm_get_wm_class(conn, c->window), wc);
+	} else if (ev->atom == XCB_ATOM_WM_NORMAL_HINTS) {
+		collect_size_hints(
+			xcb_icccm_get_wm_normal_hints(conn, c->window), wc);
+	} else if (ev->atom == wm->ewmh->_NET_WM_WINDOW_TYPE ||
+			   ev->atom == XCB_ATOM_WM_TRANSIENT_FOR) {
+		xcb_get_property_cookie_t tc =
+			xcb_ewmh_get_wm_window_type(wm->ewmh, c->window);
+		xcb_get_property_cookie_t fc =
+			xcb_icccm_get_wm_transient_for(conn, c->window);
+		collect_window_type(tc, fc, wc);
+	} else if (ev->atom == wm->ewmh->WM_PROTOCOLS) {
+		collect_protocols(xcb_icccm_get_wm_protocols(
+							  conn, c->window, wm->ewmh->WM_PROTOCOLS),
+						  wc);
+	}
+	return 0;
 }
 
 static bool
@@ -3122,71 +3104,77 @@ should_ignore_hints(xcb_window_t win, const char *name)
 static bool
 window_exists(xcb_conn_t *conn, xcb_window_t win)
 {
+	const bool alive = registry_contains(win);
+#ifdef _DEBUG__
+	/* debug builds still ask the server, to catch the registry missing
+	 * a create or destroy event */
 	xcb_query_tree_cookie_t c = xcb_query_tree(conn, win);
 	xcb_query_tree_reply_t *tree_reply =
 		xcb_query_tree_reply(conn, c, NULL);
-
-	if (tree_reply == NULL) {
-		return false;
+	if ((tree_reply != NULL) != alive) {
+		_LOG_(WARNING,
+			  "registry says window %d is %s, server disagrees",
+			  win,
+			  alive ? "alive" : "gone");
 	}
-
 	free(tree_reply);
-	return true;
+#else
+	(void)conn;
+#endif
+	return alive;
 }
 
+/* windows that existed before zwm started never send a create notify */
 static bool
-is_transient(xcb_window_t win)
+seed_registry(void)
 {
-	xcb_window_t			  transient = XCB_NONE;
-	xcb_get_property_cookie_t c =
-		xcb_icccm_get_wm_transient_for(wm->connection, win);
-	const uint8_t r = xcb_icccm_get_wm_transient_for_reply(
-		wm->connection, c, &transient, NULL);
-
-	if (r != 1) {
+	xcb_query_tree_cookie_t c =
+		xcb_query_tree(wm->connection, wm->root_window);
+	xcb_query_tree_reply_t *tree_reply =
+		xcb_query_tree_reply(wm->connection, c, NULL);
+	if (tree_reply == NULL) {
+		_LOG_(ERROR, "Failed to query tree reply\n");
 		return false;
 	}
 
-	if (transient != XCB_NONE) {
-		return true;
+	bool		  ok	   = registry_add(wm->root_window) == 0;
+	xcb_window_t *children = xcb_query_tree_children(tree_reply);
+	const int	  len	   = xcb_query_tree_children_length(tree_reply);
+	for (int i = 0; ok && i < len; i++) {
+		ok = registry_add(children[i]) == 0;
 	}
-	return false;
+
+	free(tree_reply);
+	return ok;
 }
 
 static int
 handle_first_window(client_t *client, desktop_t *d)
 {
-	rectangle_t	   r = {0};
-	const uint16_t w = cur_monitor->rectangle.width;
-	const uint16_t h = cur_monitor->rectangle.height;
-	const uint16_t x = cur_monitor->rectangle.x;
-	const uint16_t y = cur_monitor->rectangle.y;
-
-	if (wm->bar != NULL && cur_monitor == prim_monitor) {
-		r.x		 = x + conf.window_gap;
-		r.y		 = y + wm->bar->rectangle.height + conf.window_gap;
-		r.width	 = w - 2 * conf.window_gap - 2 * conf.border_width;
-		r.height = h - wm->bar->rectangle.height - 2 * conf.window_gap -
-				   2 * conf.border_width;
-	} else {
-		r.x		 = x + conf.window_gap;
-		r.y		 = y + conf.window_gap;
-		r.width	 = w - 2 * conf.window_gap - 2 * conf.border_width;
-		r.height = h - 2 * conf.window_gap - 2 * conf.border_width;
-	}
+	const layout_params_t lp   = get_layout_params();
+	const rectangle_t	  area = get_work_area(d->monitor);
+	const rectangle_t	  r	   = layout_root_rect(area, &lp);
 
 	if (client == NULL) {
 		_LOG_(ERROR, "client is null");
 		return -1;
 	}
 
-	d->tree			   = init_root();
+	d->tree = init_root(d);
+	if (d->tree == NULL) {
+		_LOG_(ERROR, "cannot allocate memory for root");
+		pool_release(&d->client_pool, client);
+		return -1;
+	}
 	d->tree->client	   = client;
 	d->tree->rectangle = r;
 	d->n_count += 1;
+	relink_leaves(d);
+	registry_attach(client->window, d->monitor, d, d->tree);
 
 	// ewmh_update_client_list();
-	return tile(d->tree);
+	schedule_render(d);
+	return 0;
 }
 
 static int
@@ -3196,6 +3184,7 @@ handle_subsequent_window(client_t *client, desktop_t *d)
 		get_window_under_cursor(wm->connection, wm->root_window);
 	node_t *n = NULL;
 	if (wi == wm->root_window || wi == 0) {
+		pool_release(&d->client_pool, client);
 		return 0;
 	}
 
@@ -3207,6 +3196,7 @@ handle_subsequent_window(client_t *client, desktop_t *d)
 			char *name = win_name(wi);
 			_LOG_(INFO, "cannot find win under cursor %s:%d", wi);
 			free(name);
+			pool_release(&d->client_pool, client);
 			return 0;
 		}
 	}
@@ -3214,8 +3204,10 @@ handle_subsequent_window(client_t *client, desktop_t *d)
 	if (n->client->state == FLOATING) {
 		_LOG_(ERROR, "node under cursor is floating %d", wi);
 		n = find_left_leaf(d->tree);
-		if (n == NULL)
+		if (n == NULL) {
+			pool_release(&d->client_pool, client);
 			return 0;
+		}
 	}
 
 	if (n->client->state == FULLSCREEN) {
@@ -3224,6 +3216,7 @@ handle_subsequent_window(client_t *client, desktop_t *d)
 
 	if (n == NULL || n->client == NULL) {
 		_LOG_(ERROR, "cannot find node with window id %d", wi);
+		pool_release(&d->client_pool, client);
 		return -1;
 	}
 
@@ -3232,20 +3225,22 @@ handle_subsequent_window(client_t *client, desktop_t *d)
 		return -1;
 	}
 
-	node_t *new_node = create_node(client);
+	node_t *new_node = create_node(client, d);
 	if (new_node == NULL) {
 		_LOG_(ERROR, "new node is null");
+		pool_release(&d->client_pool, client);
 		return -1;
 	}
 
-	insert_node(n, new_node, d->layout);
+	insert_node(n, new_node, d);
 	d->n_count += 1;
 	if (d->layout == STACK) {
 		set_focus(new_node, true);
+		update_focus(d, new_node);
 		d->top_w = new_node->client->window;
 	}
 	// ewmh_update_client_list();
-	return render_tree(d->tree);
+	return 0;
 }
 
 static int
@@ -3255,7 +3250,7 @@ handle_floating_window(client_t *client, desktop_t *d)
 		get_window_under_cursor(wm->connection, wm->root_window);
 
 	if (wi == wm->root_window || wi == 0) {
-		free(client);
+		pool_release(&d->client_pool, client);
 		return 0;
 	}
 
@@ -3263,15 +3258,15 @@ handle_floating_window(client_t *client, desktop_t *d)
 
 	n		  = n == NULL ? find_left_leaf(d->tree) : n;
 	if (n == NULL || n->client == NULL) {
-		free(client);
+		pool_release(&d->client_pool, client);
 		_LOG_(ERROR, "cannot find node with window id %d", wi);
 		return -1;
 	}
 
-	node_t *new_node = create_node(client);
+	node_t *new_node = create_node(client, d);
 	if (new_node == NULL) {
-		free(client);
 		_LOG_(ERROR, "new node is null");
+		pool_release(&d->client_pool, client);
 		return -1;
 	}
 
@@ -3279,6 +3274,8 @@ handle_floating_window(client_t *client, desktop_t *d)
 		get_geometry(client->window, wm->connection);
 	if (g == NULL) {
 		_LOG_(ERROR, "cannot get %d geometry", client->window);
+		pool_release(&d->node_pool, new_node);
+		pool_release(&d->client_pool, client);
 		return -1;
 	}
 
@@ -3289,22 +3286,26 @@ handle_floating_window(client_t *client, desktop_t *d)
 	new_node->rectangle = new_node->floating_rectangle = rc;
 	free(g);
 
-	insert_node(n, new_node, d->layout);
+	insert_node(n, new_node, d);
 	d->n_count += 1;
 	// ewmh_update_client_list();
 
-	return render_tree(d->tree);
+	return 0;
 }
 
 static int
-insert_into_desktop(int idx, xcb_window_t win, bool is_tiled)
+insert_into_desktop(int				   idx,
+					xcb_window_t	   win,
+					const win_class_t *wc,
+					bool			   is_tiled)
 {
 	desktop_t *d = cur_monitor->desktops[--idx];
 	assert(d != NULL);
 	if (find_node_by_window_id(d->tree, win) != NULL) {
 		return 0;
 	}
-	client_t *client = create_client(win, XCB_ATOM_WINDOW, wm->connection);
+	client_t *client =
+		create_client(win, XCB_ATOM_WINDOW, wc, d, wm->connection);
 	if (client == NULL) {
 		_LOG_(ERROR, "cannot allocate memory for client");
 		return -1;
@@ -3315,33 +3316,26 @@ insert_into_desktop(int idx, xcb_window_t win, bool is_tiled)
 		window_grab_buttons(client->window);
 	}
 	if (is_tree_empty(d->tree)) {
-		rectangle_t	   r = {0};
-		const uint16_t w = cur_monitor->rectangle.width;
-		const uint16_t h = cur_monitor->rectangle.height;
-		const uint16_t x = cur_monitor->rectangle.x;
-		const uint16_t y = cur_monitor->rectangle.y;
-		if (wm->bar != NULL && cur_monitor == prim_monitor) {
-			r.x		 = x + conf.window_gap;
-			r.y		 = y + wm->bar->rectangle.height + conf.window_gap;
-			r.width	 = w - 2 * conf.window_gap - 2 * conf.border_width;
-			r.height = h - wm->bar->rectangle.height -
-					   2 * conf.window_gap - 2 * conf.border_width;
-		} else {
-			r.x		 = x + conf.window_gap;
-			r.y		 = y + conf.window_gap;
-			r.width	 = w - 2 * conf.window_gap - 2 * conf.border_width;
-			r.height = h - 2 * conf.window_gap - 2 * conf.border_width;
-		}
+		const layout_params_t lp   = get_layout_params();
+		const rectangle_t	  area = get_work_area(d->monitor);
+		const rectangle_t	  r	   = layout_root_rect(area, &lp);
 
 		if (client == NULL) {
 			_LOG_(ERROR, "client is null");
 			return -1;
 		}
 
-		d->tree			   = init_root();
+		d->tree = init_root(d);
+		if (d->tree == NULL) {
+			_LOG_(ERROR, "cannot allocate memory for root");
+			pool_release(&d->client_pool, client);
+			return -1;
+		}
 		d->tree->client	   = client;
 		d->tree->rectangle = r;
 		d->n_count += 1;
+		relink_leaves(d);
+		registry_attach(client->window, d->monitor, d, d->tree);
 		// ewmh_update_client_list();
 	} else {
 		node_t *n = NULL;
@@ -3350,10 +3344,12 @@ insert_into_desktop(int idx, xcb_window_t win, bool is_tiled)
 			char *name = win_name(win);
 			_LOG_(INFO, "cannot find win  %s:%d", win);
 			free(name);
+			pool_release(&d->client_pool, client);
 			return 0;
 		}
 
 		if (n->client->state == FLOATING) {
+			pool_release(&d->client_pool, client);
 			return 0;
 		}
 
@@ -3361,9 +3357,10 @@ insert_into_desktop(int idx, xcb_window_t win, bool is_tiled)
 			set_fullscreen(n, false);
 		}
 
-		node_t *new_node = create_node(client);
+		node_t *new_node = create_node(client, d);
 		if (new_node == NULL) {
 			_LOG_(ERROR, "new node is null");
+			pool_release(&d->client_pool, client);
 			return -1;
 		}
 
@@ -3372,6 +3369,8 @@ insert_into_desktop(int idx, xcb_window_t win, bool is_tiled)
 				get_geometry(client->window, wm->connection);
 			if (g == NULL) {
 				_LOG_(ERROR, "cannot get %d geometry", client->window);
+				pool_release(&d->node_pool, new_node);
+				pool_release(&d->client_pool, client);
 				return -1;
 			}
 
@@ -3382,10 +3381,11 @@ insert_into_desktop(int idx, xcb_window_t win, bool is_tiled)
 			new_node->rectangle = new_node->floating_rectangle = rc;
 			free(g);
 		}
-		insert_node(n, new_node, d->layout);
+		insert_node(n, new_node, d);
 		d->n_count += 1;
 		if (d->layout == STACK) {
 			set_focus(new_node, true);
+			update_focus(d, new_node);
 			d->top_w = new_node->client->window;
 		}
 		// ewmh_update_client_list();
@@ -3403,17 +3403,16 @@ handle_map_request(const xcb_map_request_event_t *ev)
 		cur_monitor = mm;
 	}
 
-	if (!should_manage(win, wm->connection)) {
+	win_class_t wc;
+	classify_window(win, &wc);
+
+	if (wc.override_redirect) {
 		_LOG_(
 			INFO, "win %d, shouldn't be managed.. ignoring request", win);
 		return 0;
 	}
 
-	int idx = get_focused_desktop_idx();
-	if (idx == -1) {
-		_LOG_(ERROR, "cannot get focused desktop idx");
-		return idx;
-	}
+	uint32_t idx = get_focused_desktop_idx();
 
 	// check if the window already exists in the tree to avoid duplication
 	if (find_node_by_window_id(cur_monitor->desktops[idx]->tree, win) !=
@@ -3422,24 +3421,24 @@ handle_map_request(const xcb_map_request_event_t *ev)
 	}
 
 	desktop_t *d	= cur_monitor->desktops[idx];
-	rule_t	  *rule = get_window_rule(win);
+	rule_t	  *rule = get_window_rule(wc.class_name);
 
 	if (rule != NULL) {
 		if (rule->desktop_id != -1) {
 			return insert_into_desktop(
-				rule->desktop_id, win, rule->state == TILED);
+				rule->desktop_id, win, &wc, rule->state == TILED);
 		}
 		if (rule->state == FLOATING) {
-			return handle_floating_window_request(win, d);
+			return handle_floating_window_request(win, &wc, d);
 		} else if (rule->state == TILED) {
-			return handle_tiled_window_request(win, d);
+			return handle_tiled_window_request(win, &wc, d);
 		}
 	}
 
-	int wint = window_type(win);
+	int wint = wc.type;
 
-	if ((apply_floating_hints(win) != -1 && wint != 2)) {
-		return handle_floating_window_request(win, d);
+	if (wc.fixed_size && wint != 2) {
+		return handle_floating_window_request(win, &wc, d);
 	}
 
 	if (wint == 7) {
@@ -3450,20 +3449,23 @@ handle_map_request(const xcb_map_request_event_t *ev)
 	switch (wint) {
 	case -1:
 	case 0:
-	case 1: return handle_tiled_window_request(win, d);
+	case 1: return handle_tiled_window_request(win, &wc, d);
 	case 2: return handle_bar_request(win, d);
 	case 3:
 	case 4:
 	case 5:
-	case 6: return handle_floating_window_request(win, d);
+	case 6: return handle_floating_window_request(win, &wc, d);
 	default: return 0;
 	}
 }
 
 static int
-handle_tiled_window_request(xcb_window_t win, desktop_t *d)
+handle_tiled_window_request(xcb_window_t		 win,
+							const win_class_t *wc,
+							desktop_t		  *d)
 {
-	client_t *client = create_client(win, XCB_ATOM_WINDOW, wm->connection);
+	client_t *client =
+		create_client(win, XCB_ATOM_WINDOW, wc, d, wm->connection);
 	if (client == NULL) {
 		_LOG_(ERROR, "cannot allocate memory for client");
 		return -1;
@@ -3482,14 +3484,15 @@ handle_tiled_window_request(xcb_window_t win, desktop_t *d)
 }
 
 static int
-handle_floating_window_request(xcb_window_t win, desktop_t *d)
+handle_floating_window_request(xcb_window_t	   win,
+							   const win_class_t *wc,
+							   desktop_t		 *d)
 {
 #ifdef _DEBUG__
-	char *name = win_name(win);
-	_LOG_(DEBUG, "Window %s id %d is floating", name, win);
-	free(name);
+	_LOG_(DEBUG, "Window %s id %d is floating", wc->name, win);
 #endif
-	client_t *client = create_client(win, XCB_ATOM_WINDOW, wm->connection);
+	client_t *client =
+		create_client(win, XCB_ATOM_WINDOW, wc, d, wm->connection);
 	if (client == NULL) {
 		_LOG_(ERROR, "cannot allocate memory for client");
 		return -1;
@@ -3531,11 +3534,12 @@ handle_bar_request(xcb_window_t win, desktop_t *d)
 									conf.window_gap -
 									wm->bar->rectangle.height - 5;
 		d->tree->rectangle.y = wm->bar->rectangle.height + 5;
-		resize_subtree(d->tree);
+		mark_dirty(d, d->tree);
 		if (display_client(wm->bar->rectangle, wm->bar->window) != 0) {
 			return -1;
 		}
-		return render_tree(d->tree);
+		schedule_render(d);
+		return 0;
 	}
 
 	if (display_client(wm->bar->rectangle, wm->bar->window) != 0) {
@@ -3572,9 +3576,7 @@ handle_enter_notify(const xcb_enter_notify_event_t *ev)
 		return 0;
 	}
 
-	const int curd = get_focused_desktop_idx();
-	if (curd == -1)
-		return curd;
+	const uint32_t curd = get_focused_desktop_idx();
 
 	if (cur_monitor->desktops[curd]->layout == STACK) {
 		win = cur_monitor->desktops[curd]->top_w;
@@ -3599,7 +3601,7 @@ handle_enter_notify(const xcb_enter_notify_event_t *ev)
 			restackv2(root);
 		}
 		if (IS_FULLSCREEN(n->client)) {
-			if (fullscreen_focus(n->client->window)) {
+			if (fullscreen_focus(n->client)) {
 				_LOG_(ERROR, "cannot update win attributes");
 				return -1;
 			}
@@ -3620,14 +3622,14 @@ handle_enter_notify(const xcb_enter_notify_event_t *ev)
 	if (IS_FLOATING(n->client)) {
 		// restack();
 		restackv2(root);
-		if (win_focus(n->client->window, true) != 0) {
+		if (win_focus(n->client, true) != 0) {
 			_LOG_(ERROR,
 				  "cannot focus window %d (enter)",
 				  n->client->window);
 			return -1;
 		}
 	} else if (IS_FULLSCREEN(n->client)) {
-		if (fullscreen_focus(n->client->window)) {
+		if (fullscreen_focus(n->client)) {
 			_LOG_(ERROR, "cannot update win attributes");
 			return -1;
 		}
@@ -3639,14 +3641,12 @@ handle_enter_notify(const xcb_enter_notify_event_t *ev)
 	}
 
 	focused_win = n->client->window;
-	update_focus(root, n);
+	update_focus(cur_monitor->desktops[curd], n);
 
 	if (has_floating_window(root)) {
 		// restack();
 		restackv2(root);
 	}
-
-	xcb_flush(wm->connection);
 	return 0;
 }
 
@@ -3678,9 +3678,7 @@ handle_leave_notify(const xcb_leave_notify_event_t *ev)
 		return 0;
 	}
 
-	const int curd = get_focused_desktop_idx();
-	if (curd == -1)
-		return -1;
+	const uint32_t curd = get_focused_desktop_idx();
 	if (cur_monitor->desktops[curd]->layout == STACK) {
 		return 0;
 	}
@@ -3759,7 +3757,7 @@ handle_state(node_t		 *n,
 			 xcb_atom_t	  state_,
 			 unsigned int action)
 {
-	char *name = win_name(n->client->window);
+	const char *name = n->client->props.name;
 
 	if (state == wm->ewmh->_NET_WM_STATE_FULLSCREEN ||
 		state_ == wm->ewmh->_NET_WM_STATE_FULLSCREEN) {
@@ -3768,18 +3766,15 @@ handle_state(node_t		 *n,
 			  n->client->window,
 			  name);
 		if (action == XCB_EWMH_WM_STATE_ADD) {
-			free(name);
 			return set_fullscreen(n, true);
 		} else if (action == XCB_EWMH_WM_STATE_REMOVE) {
 			/* if (n->client->state == FULLSCREEN) { */
-			free(name);
 			return set_fullscreen(n, false);
 			/* } */
 		} else if (action == XCB_EWMH_WM_STATE_TOGGLE) {
 			uint32_t mode = (n->client->state == FULLSCREEN)
 								? XCB_EWMH_WM_STATE_REMOVE
 								: XCB_EWMH_WM_STATE_ADD;
-			free(name);
 			return set_fullscreen(n, mode == XCB_EWMH_WM_STATE_ADD);
 		}
 	} else if (state == wm->ewmh->_NET_WM_STATE_BELOW) {
@@ -3810,7 +3805,6 @@ handle_state(node_t		 *n,
 			  n->client->window,
 			  name);
 	}
-	free(name);
 	return 0;
 }
 
@@ -3831,9 +3825,7 @@ handle_client_message(const xcb_client_message_event_t *client_message)
 		return 0;
 	}
 
-	int d = get_focused_desktop_idx();
-	if (d == -1)
-		return d;
+	uint32_t d = get_focused_desktop_idx();
 
 	node_t *root = cur_monitor->desktops[d]->tree;
 
@@ -3847,7 +3839,7 @@ handle_client_message(const xcb_client_message_event_t *client_message)
 			DEBUG, "data32[%d]: %u\n", i, client_message->data.data32[i]);
 	}
 #endif
-	char *s = win_name(client_message->window);
+	const char *s = n->client->props.name;
 	if (client_message->type == wm->ewmh->_NET_CURRENT_DESKTOP) {
 		uint32_t nd = client_message->data.data32[0];
 		if (nd > wm->ewmh->_NET_NUMBER_OF_DESKTOPS - 1) {
@@ -3891,7 +3883,6 @@ handle_client_message(const xcb_client_message_event_t *client_message)
 	// TODO: ewmh->_NET_WM_DESKTOP
 	// TODO: ewmh->_NET_WM_STATE_FULLSCREEN
 	// TODO: ewmh->_NET_ACTIVE_WINDOW
-	free(s);
 	return 0;
 }
 
@@ -3899,33 +3890,17 @@ static int
 handle_unmap_notify(xcb_unmap_notify_event_t *ev)
 {
 	xcb_window_t win = ev->window;
-	int			 idx = get_focused_desktop_idx();
-	if (idx == -1)
-		return -1;
 
 	if (wm->bar != NULL && wm->bar->window == win) {
 		xcb_void_cookie_t cookie = xcb_unmap_window(wm->connection, win);
-		xcb_generic_error_t *err =
-			xcb_request_check(wm->connection, cookie);
-
-		if (err != NULL) {
-			_LOG_(ERROR,
-				  "Error in unmapping window %d: error code %d",
-				  win,
-				  err->error_code);
-			free(err);
-			return -1;
-		}
+		track_request(cookie, win, OP_UNMAP);
 		free(wm->bar);
 		wm->bar = NULL;
 		return 0;
 	}
 
-	node_t *root = cur_monitor->desktops[idx]->tree;
-	if (root == NULL)
-		return 0;
-
-	if (!client_exist(root, win)) {
+	const client_t *c = find_managed_client(win);
+	if (c == NULL) {
 #ifdef _DEBUG__
 		char *name = win_name(win);
 		_LOG_(DEBUG, "cannot find win %d, name %s", win, name);
@@ -3934,6 +3909,12 @@ handle_unmap_notify(xcb_unmap_notify_event_t *ev)
 		return 0;
 	}
 
+	/* hide_window() clears is_mapped before it unmaps, so this unmap
+	 * came from zwm itself (desktop switch or transfer) */
+	if (!c->is_mapped) {
+		return 0;
+	}
+
 	if (kill_window(win) != 0) {
 		_LOG_(ERROR, "cannot kill window %d (unmap)", win);
 		return -1;
@@ -3945,35 +3926,21 @@ handle_unmap_notify(xcb_unmap_notify_event_t *ev)
 static void
 handle_configure_request(const xcb_configure_request_event_t *e)
 {
-	xcb_window_t						win = e->window;
+	xcb_window_t win = e->window;
 
-	xcb_icccm_get_text_property_reply_t t_reply;
-	xcb_get_property_cookie_t			cn =
-		xcb_icccm_get_wm_name(wm->connection, e->window);
-	const uint8_t wr =
-		xcb_icccm_get_wm_name_reply(wm->connection, cn, &t_reply, NULL);
-	char name[256];
-	if (wr == 1) {
-		snprintf(name, sizeof(name), "%s", t_reply.name);
-		xcb_icccm_get_text_property_reply_wipe(&t_reply);
-	} else {
-		return;
-	}
 #ifdef _DEBUG__
+	const client_t *c = find_managed_client(win);
 	_LOG_(DEBUG,
 		  "window %d  name %s wants to be at %dx%d with %dx%d\n",
 		  win,
-		  name,
+		  c != NULL ? c->props.name : NULL_STR,
 		  e->x,
 		  e->y,
 		  e->width,
 		  e->height);
 #endif
 
-	const int d = get_focused_desktop_idx();
-	if (d == -1) {
-		return;
-	}
+	const uint32_t d = get_focused_desktop_idx();
 
 	node_t *n		   = cur_monitor->desktops[d]->tree;
 	bool	is_managed = client_exist(n, win);
@@ -4032,34 +3999,17 @@ handle_configure_request(const xcb_configure_request_event_t *e)
 static int
 handle_destroy_notify(const xcb_destroy_notify_event_t *ev)
 {
-	xcb_window_t win = ev->event;
-	int			 idx = get_focused_desktop_idx();
-	if (idx == -1)
-		return -1;
+	xcb_window_t win = ev->window;
 
 	if (wm->bar != NULL && wm->bar->window == win) {
 		xcb_void_cookie_t cookie = xcb_unmap_window(wm->connection, win);
-		xcb_generic_error_t *err =
-			xcb_request_check(wm->connection, cookie);
-
-		if (err != NULL) {
-			_LOG_(ERROR,
-				  "Error in unmapping window %d: error code %d",
-				  win,
-				  err->error_code);
-			free(err);
-			return -1;
-		}
+		track_request(cookie, win, OP_UNMAP);
 		free(wm->bar);
 		wm->bar = NULL;
 		return 0;
 	}
 
-	node_t *root = cur_monitor->desktops[idx]->tree;
-	if (root == NULL)
-		return 0;
-
-	if (!client_exist(root, win)) {
+	if (find_managed_client(win) == NULL) {
 #ifdef _DEBUG__
 		char *name = win_name(win);
 		_LOG_(DEBUG, "cannot find win %d, name %s", win, name);
@@ -4128,9 +4078,7 @@ handle_button_press_event(const xcb_button_press_event_t *ev)
 		return;
 	}
 
-	const int curd = get_focused_desktop_idx();
-	if (curd == -1)
-		return;
+	const uint32_t curd = get_focused_desktop_idx();
 
 	if (cur_monitor->desktops[curd]->layout == STACK) {
 		win = cur_monitor->desktops[curd]->top_w;
@@ -4159,14 +4107,14 @@ handle_button_press_event(const xcb_button_press_event_t *ev)
 
 	if (IS_FLOATING(n->client)) {
 		restack();
-		if (win_focus(n->client->window, true) != 0) {
+		if (win_focus(n->client, true) != 0) {
 			_LOG_(ERROR,
 				  "cannot focus window %d (enter)",
 				  n->client->window);
 			return;
 		}
 	} else if (IS_FULLSCREEN(n->client)) {
-		if (fullscreen_focus(n->client->window)) {
+		if (fullscreen_focus(n->client)) {
 			_LOG_(ERROR, "cannot update win attributes");
 			return;
 		}
@@ -4181,10 +4129,9 @@ handle_button_press_event(const xcb_button_press_event_t *ev)
 	// 	restack(root);
 	// }
 
-	update_focus(root, n);
+	update_focus(cur_monitor->desktops[curd], n);
 	xcb_allow_events(wm->connection, XCB_ALLOW_SYNC_POINTER, ev->time);
 	// set_cursor(CURSOR_POINTER);
-	xcb_flush(wm->connection);
 }
 
 static int
@@ -4256,144 +4203,227 @@ parse_args(int argc, char **argv)
 }
 
 static void
-event_loop(wm_t *w)
+handle_event(xcb_generic_event_t *event)
 {
-	xcb_generic_event_t *event;
-	while ((event = xcb_wait_for_event(w->connection))) {
-		switch (event->response_type & ~0x80) {
-		case XCB_MAP_REQUEST: {
-			xcb_map_request_event_t *map_request =
-				(xcb_map_request_event_t *)event;
-			if (handle_map_request(map_request) != 0) {
-				_LOG_(ERROR,
-					  "Failed to handle MAP_REQUEST for window %d\n",
-					  map_request->window);
-			}
-			break;
-		}
-		case XCB_UNMAP_NOTIFY: {
-			xcb_unmap_notify_event_t *unmap_notify =
-				(xcb_unmap_notify_event_t *)event;
-			if (handle_unmap_notify(unmap_notify) != 0) {
-				_LOG_(ERROR,
-					  "Failed to handle XCB_UNMAP_NOTIFY for "
-					  "window %d\n",
-					  unmap_notify->window);
-			}
-			break;
-		}
-		case XCB_DESTROY_NOTIFY: {
-			xcb_destroy_notify_event_t *destroy_notify =
-				(xcb_destroy_notify_event_t *)event;
-			if (handle_destroy_notify(destroy_notify) != 0) {
-				_LOG_(ERROR,
-					  "Failed to handle XCB_DESTROY_NOTIFY for "
-					  "window %d\n",
-					  destroy_notify->window);
-			}
-			break;
-		}
-		case XCB_EXPOSE: {
-			__attribute__((unused)) xcb_expose_event_t *expose_event =
-				(xcb_expose_event_t *)event;
-			break;
-		}
-		case XCB_CLIENT_MESSAGE: {
-			xcb_client_message_event_t *client_message =
-				(xcb_client_message_event_t *)event;
-			handle_client_message(client_message);
-			break;
-		}
-		case XCB_CONFIGURE_REQUEST: {
-			xcb_configure_request_event_t *config_request =
-				(xcb_configure_request_event_t *)event;
-			handle_configure_request(config_request);
-			break;
-		}
-		case XCB_CONFIGURE_NOTIFY: {
-			__attribute__((unused))
-			xcb_configure_notify_event_t *config_notify =
-				(xcb_configure_notify_event_t *)event;
-			break;
-		}
-		case XCB_PROPERTY_NOTIFY: {
-			__attribute__((unused))
-			xcb_property_notify_event_t *property_notify =
-				(xcb_property_notify_event_t *)event;
-			break;
-		}
-		case XCB_ENTER_NOTIFY: {
-			xcb_enter_notify_event_t *enter_event =
-				(xcb_enter_notify_event_t *)event;
-			if (handle_enter_notify(enter_event) != 0) {
-				_LOG_(ERROR,
-					  "Failed to handle XCB_ENTER_NOTIFY for "
-					  "window %d\n",
-					  enter_event->event);
-			}
-			break;
-		}
-		case XCB_LEAVE_NOTIFY: {
-			__attribute__((unused)) xcb_leave_notify_event_t *leave_event =
-				(xcb_leave_notify_event_t *)event;
-			// if (handle_leave_notify(leave_event) != 0) {
-			// 	_LOG_(ERROR,
-			// 				"Failed to handle XCB_LEAVE_NOTIFY for "
-			// 				"window %d\n",
-			// 				leave_event->event);
-			// }
-			break;
-		}
-		case XCB_MOTION_NOTIFY: {
-			__attribute__((unused))
-			xcb_motion_notify_event_t *motion_notify =
-				(xcb_motion_notify_event_t *)event;
-			break;
-		}
-		case XCB_BUTTON_PRESS: {
-			xcb_button_press_event_t *button_press =
-				(xcb_button_press_event_t *)event;
-			handle_button_press_event(button_press);
-			break;
-		}
-		case XCB_BUTTON_RELEASE: {
-			__attribute__((unused))
-			xcb_button_release_event_t *button_release =
-				(xcb_button_release_event_t *)event;
-			break;
-		}
-		case XCB_KEY_PRESS: {
-			xcb_key_press_event_t *key_press =
-				(xcb_key_press_event_t *)event;
-			handle_key_press(key_press);
-			break;
+	switch (event->response_type & ~0x80) {
+	case 0: {
+		handle_x_error((xcb_generic_error_t *)event);
+		break;
+	}
+	case XCB_CREATE_NOTIFY: {
+		xcb_create_notify_event_t *create_notify =
+			(xcb_create_notify_event_t *)event;
+		registry_add(create_notify->window);
+		break;
+	}
+	case XCB_MAP_REQUEST: {
+		xcb_map_request_event_t *map_request =
+			(xcb_map_request_event_t *)event;
+		registry_add(map_request->window);
+		if (handle_map_request(map_request) != 0) {
+			_LOG_(ERROR,
+				  "Failed to handle MAP_REQUEST for window %d\n",
+				  map_request->window);
 		}
-		case XCB_KEY_RELEASE: {
-			__attribute__((unused)) xcb_key_release_event_t *key_release =
-				(xcb_key_release_event_t *)event;
-			break;
+		break;
+	}
+	case XCB_UNMAP_NOTIFY: {
+		xcb_unmap_notify_event_t *unmap_notify =
+			(xcb_unmap_notify_event_t *)event;
+		invalidate_pointer();
+		if (handle_unmap_notify(unmap_notify) != 0) {
+			_LOG_(ERROR,
+				  "Failed to handle XCB_UNMAP_NOTIFY for "
+				  "window %d\n",
+				  unmap_notify->window);
 		}
-		case XCB_FOCUS_IN: {
-			__attribute__((unused)) xcb_focus_in_event_t *focus_in_event =
-				(xcb_focus_in_event_t *)event;
-			break;
+		break;
+	}
+	case XCB_DESTROY_NOTIFY: {
+		xcb_destroy_notify_event_t *destroy_notify =
+			(xcb_destroy_notify_event_t *)event;
+		invalidate_pointer();
+		if (handle_destroy_notify(destroy_notify) != 0) {
+			_LOG_(ERROR,
+				  "Failed to handle XCB_DESTROY_NOTIFY for "
+				  "window %d\n",
+				  destroy_notify->window);
 		}
-		case XCB_FOCUS_OUT: {
-			__attribute__((unused))
-			xcb_focus_out_event_t *focus_out_event =
-				(xcb_focus_out_event_t *)event;
-			break;
+		registry_remove(destroy_notify->window);
+		break;
+	}
+	case XCB_EXPOSE: {
+		__attribute__((unused)) xcb_expose_event_t *expose_event =
+			(xcb_expose_event_t *)event;
+		break;
+	}
+	case XCB_CLIENT_MESSAGE: {
+		xcb_client_message_event_t *client_message =
+			(xcb_client_message_event_t *)event;
+		handle_client_message(client_message);
+		break;
+	}
+	case XCB_CONFIGURE_REQUEST: {
+		xcb_configure_request_event_t *config_request =
+			(xcb_configure_request_event_t *)event;
+		handle_configure_request(config_request);
+		break;
+	}
+	case XCB_CONFIGURE_NOTIFY: {
+		__attribute__((unused))
+		xcb_configure_notify_event_t *config_notify =
+			(xcb_configure_notify_event_t *)event;
+		break;
+	}
+	case XCB_PROPERTY_NOTIFY: {
+		xcb_property_notify_event_t *property_notify =
+			(xcb_property_notify_event_t *)event;
+		handle_property_notify(property_notify);
+		break;
+	}
+	case XCB_ENTER_NOTIFY: {
+		xcb_enter_notify_event_t *enter_event =
+			(xcb_enter_notify_event_t *)event;
+		track_pointer(enter_event->event,
+					  enter_event->child,
+					  enter_event->root_x,
+					  enter_event->root_y);
+		if (handle_enter_notify(enter_event) != 0) {
+			_LOG_(ERROR,
+				  "Failed to handle XCB_ENTER_NOTIFY for "
+				  "window %d\n",
+				  enter_event->event);
 		}
-		case XCB_MAPPING_NOTIFY: {
-			xcb_mapping_notify_event_t *mapping_notify =
-				(xcb_mapping_notify_event_t *)event;
-			handle_mapping_notify(mapping_notify);
+		break;
+	}
+	case XCB_LEAVE_NOTIFY: {
+		__attribute__((unused)) xcb_leave_notify_event_t *leave_event =
+			(xcb_leave_notify_event_t *)event;
+		/* the root does not report motion, so once the pointer is off a
+		 * client its position is only known by asking */
+		invalidate_pointer();
+		// if (handle_leave_notify(leave_event) != 0) {
+		// 	_LOG_(ERROR,
+		// 				"Failed to handle XCB_LEAVE_NOTIFY for "
+		// 				"window %d\n",
+		// 				leave_event->event);
+		// }
+		break;
+	}
+	case XCB_MOTION_NOTIFY: {
+		xcb_motion_notify_event_t *motion_notify =
+			(xcb_motion_notify_event_t *)event;
+		track_pointer(motion_notify->event,
+					  motion_notify->child,
+					  motion_notify->root_x,
+					  motion_notify->root_y);
+		break;
+	}
+	case XCB_BUTTON_PRESS: {
+		xcb_button_press_event_t *button_press =
+			(xcb_button_press_event_t *)event;
+		track_pointer(button_press->event,
+					  button_press->child,
+					  button_press->root_x,
+					  button_press->root_y);
+		handle_button_press_event(button_press);
+		break;
+	}
+	case XCB_BUTTON_RELEASE: {
+		__attribute__((unused))
+		xcb_button_release_event_t *button_release =
+			(xcb_button_release_event_t *)event;
+		break;
+	}
+	case XCB_KEY_PRESS: {
+		xcb_key_press_event_t *key_press =
+			(xcb_key_press_event_t *)event;
+		track_pointer(key_press->event,
+					  key_press->child,
+					  key_press->root_x,
+					  key_press->root_y);
+		handle_key_press(key_press);
+		break;
+	}
+	case XCB_KEY_RELEASE: {
+		__attribute__((unused)) xcb_key_release_event_t *key_release =
+			(xcb_key_release_event_t *)event;
+		break;
+	}
+	case XCB_FOCUS_IN: {
+		__attribute__((unused)) xcb_focus_in_event_t *focus_in_event =
+			(xcb_focus_in_event_t *)event;
+		break;
+	}
+	case XCB_FOCUS_OUT: {
+		__attribute__((unused))
+		xcb_focus_out_event_t *focus_out_event =
+			(xcb_focus_out_event_t *)event;
+		break;
+	}
+	case XCB_MAPPING_NOTIFY: {
+		xcb_mapping_notify_event_t *mapping_notify =
+			(xcb_mapping_notify_event_t *)event;
+		handle_mapping_notify(mapping_notify);
+	}
+	default: {
+		break;
+	}
+	}
+}
+
+/* layout changes are applied once per batch of events by event_loop,
+ * however many handlers in that batch touched the desktop */
+void
+schedule_render(desktop_t *d)
+{
+	if (d != NULL) {
+		d->is_dirty = true;
+	}
+}
+
+static void
+render_dirty_desktops(void)
+{
+	for (monitor_t *m = head_monitor; m != NULL; m = m->next) {
+		/* hidden desktops are drawn when they are switched to */
+		desktop_t *d = m->focused_desktop;
+		if (d == NULL) {
+			continue;
 		}
-		default: {
-			break;
+		/* a scheduled render tiles every window, otherwise only the
+		 * subtrees marked by the last inserts, deletes and resizes */
+		int ret;
+		if (d->is_dirty) {
+			d->is_dirty = false;
+			ret			= render_tree(d);
+		} else {
+			ret = render_changes(d);
 		}
+		if (ret != 0) {
+			_LOG_(ERROR, "cannot render desktop %s", d->name);
 		}
-		free(event);
+	}
+}
+
+static void
+event_loop(wm_t *w)
+{
+	xcb_generic_event_t *event;
+	while ((event = xcb_wait_for_event(w->connection))) {
+		/* handle everything already queued before laying anything out,
+		 * so a burst of events costs one render pass per desktop and a
+		 * single flush */
+		do {
+			handle_event(event);
+			free(event);
+		} while ((event = xcb_poll_for_queued_event(w->connection)));
+
+		render_dirty_desktops();
+#ifdef _DEBUG__
+		log_request_counts();
+#endif
+		xcb_flush(w->connection);
 	}
 }
 
@@ -4405,6 +4435,7 @@ cleanup(int sig)
 	free_keys();
 	free_rules();
 	free_monitors(); // frees desktops and trees as well
+	registry_free();
 	free(wm);
 	wm = NULL;
 	_LOG_(INFO, "ZWM exits with signal number %d", sig);
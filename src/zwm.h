@@ -56,14 +56,18 @@ int    	     cycle_win_wrapper(arg_t *arg);
 int  		 set_fullscreen_wrapper();
 int 		 flip_node_wrapper();
 int          reload_config_wrapper();
-int          hide_window(xcb_window_t win);
-int          get_focused_desktop_idx();
-int          show_window(xcb_window_t win);
+int          hide_window(client_t *c);
+uint32_t     get_focused_desktop_idx();
+int          show_window(client_t *c);
 int 		 switch_desktop_wrapper(arg_t *arg);
 int 		 cycle_desktop_wrapper(arg_t *arg);
 int 	     close_or_kill_wrapper();
 int 		 traverse_stack_wrapper(arg_t *arg);
 int          tile(node_t *node);
+void         schedule_render(desktop_t *d);
+monitor_t   *get_monitor_from_desktop(desktop_t *desktop);
+layout_params_t get_layout_params(void);
+rectangle_t  get_work_area(const monitor_t *m);
 int 		 set_focus(node_t *n, bool flag);
 int 		 swap_node_wrapper();
 #endif // ZWM_ZWM_H